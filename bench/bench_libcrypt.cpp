@@ -0,0 +1,383 @@
+#include <libcrypt.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <fstream>
+#include <random>
+
+using namespace libcrypt;
+
+static std::vector<uint8_t> make_buffer(size_t size) {
+    std::vector<uint8_t> buffer(size);
+    for (size_t i = 0; i < size; i++)
+        buffer[i] = (uint8_t)(i * 31 + 7);
+
+    return buffer;
+}
+
+static std::filesystem::path make_file(size_t size) {
+    auto path   = std::filesystem::temp_directory_path() / "libcrypt_bench_input.bin";
+    auto buffer = make_buffer(size);
+
+    std::ofstream out(path, std::ios::binary);
+    out.write((const char*)buffer.data(), buffer.size());
+
+    return path;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// MD5
+
+static void md5_compute(benchmark::State& state) {
+    auto buffer = make_buffer((size_t)state.range(0));
+    md5  md5;
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(md5.compute(buffer.data(), buffer.size()));
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(md5_compute)->RangeMultiplier(16)->Range(16, 1 << 30)->Unit(benchmark::kMicrosecond);
+
+static void md5_compute_many(benchmark::State& state) {
+    std::vector<std::vector<uint8_t>>     buffers(256, make_buffer((size_t)state.range(0)));
+    std::vector<std::span<const uint8_t>> messages(buffers.begin(), buffers.end());
+    md5 md5;
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(md5.compute_many(messages));
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * buffers.size());
+}
+
+BENCHMARK(md5_compute_many)->RangeMultiplier(16)->Range(16, 1 << 16)->Unit(benchmark::kMicrosecond);
+
+// 256 messages sharing a 64 KiB prefix, argument is the suffix size
+static void md5_compute_suffixes(benchmark::State& state) {
+    auto prefix = make_buffer(64 << 10);
+    auto suffix = make_buffer((size_t)state.range(0));
+
+    std::vector<md5::segment_t> suffixes(256, md5::segment_t(suffix));
+    md5 md5;
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(md5.compute_suffixes(prefix, suffixes));
+
+    state.SetItemsProcessed(state.iterations() * suffixes.size());
+}
+
+BENCHMARK(md5_compute_suffixes)->Arg(64)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+static void hmac_md5_compute(benchmark::State& state) {
+    auto     buffer = make_buffer((size_t)state.range(0));
+    hmac_md5 hmac;
+
+    hmac.set_key("benchmark");
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(hmac.compute(buffer.data(), buffer.size()));
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(hmac_md5_compute)->Arg(16)->Arg(64)->Arg(1024);
+
+///////////////////////////////////////////////////////////////////////////////
+// RC4
+
+static void rc4_encrypt_buffer(benchmark::State& state) {
+    auto buffer = make_buffer((size_t)state.range(0));
+    rc4  rc4;
+
+    rc4.set_key("benchmark");
+
+    for (auto _ : state) {
+        rc4.encrypt_buffer(buffer);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(rc4_encrypt_buffer)->RangeMultiplier(16)->Range(16, 1 << 28)->Unit(benchmark::kMicrosecond);
+
+static void rc4_encrypt_then_md5(benchmark::State& state) {
+    auto buffer = make_buffer((size_t)state.range(0));
+    rc4  rc4;
+    md5  md5;
+
+    rc4.set_key("benchmark");
+
+    for (auto _ : state) {
+        rc4.encrypt_buffer(buffer);
+        benchmark::DoNotOptimize(md5.compute(buffer.data(), buffer.size()));
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(rc4_encrypt_then_md5)->Arg(64 << 10)->Arg(256 << 20)->Unit(benchmark::kMicrosecond);
+
+static void rc4_encrypt_buffer_hash(benchmark::State& state) {
+    auto buffer = make_buffer((size_t)state.range(0));
+    rc4  rc4;
+
+    rc4::hash_t hash;
+    rc4.set_key("benchmark");
+
+    for (auto _ : state) {
+        rc4.encrypt_buffer(buffer, hash);
+        benchmark::DoNotOptimize(hash);
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(rc4_encrypt_buffer_hash)->Arg(64 << 10)->Arg(256 << 20)->Unit(benchmark::kMicrosecond);
+
+// Crypts 16 MiB split into segments, argument is the segment size
+static void rc4_encrypt_segments(benchmark::State& state) {
+    static const size_t SIZE = 16 << 20;
+
+    auto buffer = make_buffer(SIZE);
+    rc4  rc4;
+
+    std::vector<rc4::segment_t> segments;
+    size_t step = (size_t)state.range(0);
+    for (size_t i = 0; i < SIZE; i += step)
+        segments.emplace_back(&buffer[i], std::min(step, SIZE - i));
+
+    rc4.set_key("benchmark");
+
+    for (auto _ : state) {
+        rc4.encrypt_buffer(segments);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * SIZE);
+}
+
+BENCHMARK(rc4_encrypt_segments)->Arg(64)->Arg(1500)->Arg(64 << 10)->Unit(benchmark::kMicrosecond);
+
+// Key schedule, same work as rc4::generate_box()
+static void rc4_generate_box(benchmark::State& state) {
+    std::string key = "benchmark";
+    uint8_t     iv  = 0U;
+
+    for (auto _ : state) {
+        rc4_key_schedule schedule(key, iv++);
+        benchmark::DoNotOptimize(schedule.get_box());
+    }
+}
+
+BENCHMARK(rc4_generate_box);
+
+// Fresh object per 64 byte message, key scheduled at runtime
+static void rc4_encrypt_small_message(benchmark::State& state) {
+    auto buffer = make_buffer(64);
+
+    for (auto _ : state) {
+        rc4 rc4;
+        rc4.set_key("benchmark");
+        rc4.encrypt_buffer(buffer);
+        benchmark::ClobberMemory();
+    }
+}
+
+BENCHMARK(rc4_encrypt_small_message);
+
+// Fresh object per 64 byte message, key scheduled at compile time
+static void rc4_static_encrypt_small_message(benchmark::State& state) {
+    auto buffer = make_buffer(64);
+
+    for (auto _ : state) {
+        rc4_static<"benchmark"> rc4;
+        rc4.encrypt_buffer(buffer);
+        benchmark::ClobberMemory();
+    }
+}
+
+BENCHMARK(rc4_static_encrypt_small_message);
+
+// Reads 4 KiB at random offsets of a 64 MiB stream.
+// Argument selects checkpoints every 64 KiB.
+static void rc4_decrypt_stream_seek(benchmark::State& state) {
+    static const size_t STREAM_SIZE = 64 << 20;
+    static const size_t READ_SIZE   = 4096;
+
+    auto buffer = make_buffer(READ_SIZE);
+    rc4  rc4;
+
+    rc4.set_key("benchmark");
+
+    rc4_checkpoints checkpoints;
+    if (state.range(0)) {
+        rc4.build_checkpoints(checkpoints, STREAM_SIZE, 64 << 10);
+        rc4.set_checkpoints(&checkpoints);
+    }
+
+    std::mt19937_64 random(1);
+    std::uniform_int_distribution<size_t> offsets(0, STREAM_SIZE - READ_SIZE);
+
+    for (auto _ : state) {
+        rc4.decrypt_stream(buffer.data(), buffer.size(), offsets(random));
+        benchmark::ClobberMemory();
+    }
+
+    rc4.reset();
+}
+
+BENCHMARK(rc4_decrypt_stream_seek)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// Two sequential readers of a 64 MiB stream taking turns every 4 KiB.
+// Argument is the cursor count.
+static void rc4_decrypt_stream_interleaved(benchmark::State& state) {
+    static const size_t STREAM_SIZE = 64 << 20;
+    static const size_t READ_SIZE   = 4096;
+
+    auto buffer = make_buffer(READ_SIZE);
+    rc4  rc4;
+
+    rc4.set_key("benchmark");
+    rc4.set_cursor_count((size_t)state.range(0));
+
+    size_t position = 0U;
+
+    for (auto _ : state) {
+        rc4.decrypt_stream(buffer.data(), buffer.size(), position);
+        rc4.decrypt_stream(buffer.data(), buffer.size(), STREAM_SIZE / 2 + position);
+        benchmark::ClobberMemory();
+
+        position = (position + READ_SIZE) % (STREAM_SIZE / 2);
+    }
+
+    rc4.reset();
+
+    state.SetBytesProcessed(state.iterations() * READ_SIZE * 2);
+}
+
+BENCHMARK(rc4_decrypt_stream_interleaved)->Arg(1)->Arg(4)->Unit(benchmark::kMicrosecond);
+
+// Decrypts a 256 MiB container, argument is the thread count
+static void rc4_container_decrypt_buffer(benchmark::State& state) {
+    static const size_t SIZE = 256 << 20;
+
+    auto          buffer = make_buffer(SIZE);
+    rc4_container container;
+
+    rc4_container::buffer_t encrypted;
+    container.set_key("benchmark");
+    container.encrypt_buffer(buffer, encrypted);
+    container.set_thread_count((size_t)state.range(0));
+
+    for (auto _ : state) {
+        container.decrypt_buffer(encrypted, buffer);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * SIZE);
+}
+
+BENCHMARK(rc4_container_decrypt_buffer)->Arg(1)->Arg(4)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+///////////////////////////////////////////////////////////////////////////////
+// FILES
+
+static void rc4_encrypt_file(benchmark::State& state) {
+    auto input  = make_file((size_t)state.range(0));
+    auto output = std::filesystem::temp_directory_path() / "libcrypt_bench_output.bin";
+    rc4  rc4;
+
+    rc4.set_key("benchmark");
+
+    for (auto _ : state)
+        rc4.encrypt_file(input, output);
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+}
+
+BENCHMARK(rc4_encrypt_file)->Arg(1 << 20)->Arg(64 << 20)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void rc4_decrypt_file_in_place(benchmark::State& state) {
+    auto input = make_file((size_t)state.range(0));
+    rc4  rc4;
+
+    rc4.set_key("benchmark");
+
+    for (auto _ : state)
+        rc4.decrypt_file(input);
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+
+    std::filesystem::remove(input);
+}
+
+BENCHMARK(rc4_decrypt_file_in_place)->Arg(1 << 20)->Arg(64 << 20)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void rc4_decrypt_file_to_buffer(benchmark::State& state) {
+    auto input = make_file((size_t)state.range(0));
+    rc4  rc4;
+
+    rc4::buffer_t buffer;
+    rc4.set_key("benchmark");
+
+    for (auto _ : state)
+        rc4.decrypt_file(input, buffer);
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+
+    std::filesystem::remove(input);
+}
+
+BENCHMARK(rc4_decrypt_file_to_buffer)->Arg(1 << 20)->Arg(64 << 20)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void md5_compute_file(benchmark::State& state) {
+    auto input = make_file((size_t)state.range(0));
+    md5  md5;
+
+    std::array<uint8_t, 16> hash{};
+
+    for (auto _ : state)
+        md5.compute_file(input, hash);
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+
+    std::filesystem::remove(input);
+}
+
+BENCHMARK(md5_compute_file)->Arg(1 << 20)->Arg(64 << 20)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+///////////////////////////////////////////////////////////////////////////////
+// MAIN
+
+// Results are also written to bench_libcrypt.json unless --benchmark_out is given
+int main(int argc, char** argv) {
+    static char out_arg[]    = "--benchmark_out=bench_libcrypt.json";
+    static char format_arg[] = "--benchmark_out_format=json";
+
+    std::vector<char*> args(argv, argv + argc);
+
+    bool has_out = false;
+    for (int i = 1; i < argc; i++)
+        has_out |= std::strncmp(argv[i], "--benchmark_out=", 16) == 0;
+
+    if (!has_out) {
+        args.push_back(out_arg);
+        args.push_back(format_arg);
+    }
+
+    int count = (int)args.size();
+
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
\ No newline at end of file
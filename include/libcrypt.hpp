@@ -1,4 +1,20 @@
 #pragma once
 
+#include <libcrypt/md5/hmac_md5.hpp>
 #include <libcrypt/md5/md5.hpp>
-#include <libcrypt/rc4/rc4.hpp>
\ No newline at end of file
+#include <libcrypt/md5/md5_ct.hpp>
+#include <libcrypt/md5/md5_digest_cache.hpp>
+#include <libcrypt/misc/crypt_job.hpp>
+#include <libcrypt/misc/file_queue.hpp>
+#include <libcrypt/misc/kernels.hpp>
+#include <libcrypt/misc/task.hpp>
+#include <libcrypt/misc/thread_pool.hpp>
+#include <libcrypt/rc4/rc4.hpp>
+#include <libcrypt/rc4/rc4_batch.hpp>
+#include <libcrypt/rc4/rc4_checkpoints.hpp>
+#include <libcrypt/rc4/rc4_container.hpp>
+#include <libcrypt/rc4/rc4_cursor.hpp>
+#include <libcrypt/rc4/rc4_key_schedule.hpp>
+#include <libcrypt/rc4/rc4_keystream_cache.hpp>
+#include <libcrypt/rc4/rc4_static.hpp>
+#include <libcrypt/rc4/rc4_streambuf.hpp>
\ No newline at end of file
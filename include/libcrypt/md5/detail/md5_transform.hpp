@@ -0,0 +1,139 @@
+// Adapted from:
+//     https://github.com/stbrumme/hash-library
+
+#pragma once
+
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+// MD5 round definitions shared by the scalar, multi-buffer and compile time
+// paths. T is either uint32_t or a vector of uint32_t lanes.
+//
+// Tag only separates instantiations. Kernels built with their own isa flags
+// pass a tag with internal linkage so the linker can't swap in a copy built
+// for another isa, see source/md5/md5_isa.hpp.
+
+namespace libcrypt::detail {
+    template<typename Tag, typename T>
+    inline constexpr T f1(T b, T c, T d) {
+        return d ^ (b & (c ^ d));
+    }
+
+    template<typename Tag, typename T>
+    inline constexpr T f2(T b, T c, T d) {
+        return c ^ (d & (b ^ c));
+    }
+
+    template<typename Tag, typename T>
+    inline constexpr T f3(T b, T c, T d) {
+        return b ^ c ^ d;
+    }
+
+    template<typename Tag, typename T>
+    inline constexpr T f4(T b, T c, T d) {
+        return c ^ (b | ~d);
+    }
+
+    template<typename Tag, typename T>
+    inline constexpr T rotate(T a, uint32_t c) {
+        return (a << c) | (a >> (32 - c));
+    }
+
+    // Compresses one block of 16 little endian words into hash.
+    template<typename Tag = void, typename T>
+    inline constexpr void md5_transform(T* hash, const T* words) {
+        T a = hash[0];
+        T b = hash[1];
+        T c = hash[2];
+        T d = hash[3];
+
+        // first round
+        a = rotate<Tag>(a + f1<Tag>(b, c, d) + words[0] + 0xd76aa478, 7) + b;
+        d = rotate<Tag>(d + f1<Tag>(a, b, c) + words[1] + 0xe8c7b756, 12) + a;
+        c = rotate<Tag>(c + f1<Tag>(d, a, b) + words[2] + 0x242070db, 17) + d;
+        b = rotate<Tag>(b + f1<Tag>(c, d, a) + words[3] + 0xc1bdceee, 22) + c;
+
+        a = rotate<Tag>(a + f1<Tag>(b, c, d) + words[4] + 0xf57c0faf, 7) + b;
+        d = rotate<Tag>(d + f1<Tag>(a, b, c) + words[5] + 0x4787c62a, 12) + a;
+        c = rotate<Tag>(c + f1<Tag>(d, a, b) + words[6] + 0xa8304613, 17) + d;
+        b = rotate<Tag>(b + f1<Tag>(c, d, a) + words[7] + 0xfd469501, 22) + c;
+
+        a = rotate<Tag>(a + f1<Tag>(b, c, d) + words[8] + 0x698098d8, 7) + b;
+        d = rotate<Tag>(d + f1<Tag>(a, b, c) + words[9] + 0x8b44f7af, 12) + a;
+        c = rotate<Tag>(c + f1<Tag>(d, a, b) + words[10] + 0xffff5bb1, 17) + d;
+        b = rotate<Tag>(b + f1<Tag>(c, d, a) + words[11] + 0x895cd7be, 22) + c;
+
+        a = rotate<Tag>(a + f1<Tag>(b, c, d) + words[12] + 0x6b901122, 7) + b;
+        d = rotate<Tag>(d + f1<Tag>(a, b, c) + words[13] + 0xfd987193, 12) + a;
+        c = rotate<Tag>(c + f1<Tag>(d, a, b) + words[14] + 0xa679438e, 17) + d;
+        b = rotate<Tag>(b + f1<Tag>(c, d, a) + words[15] + 0x49b40821, 22) + c;
+
+        // second round
+        a = rotate<Tag>(a + f2<Tag>(b, c, d) + words[1] + 0xf61e2562, 5) + b;
+        d = rotate<Tag>(d + f2<Tag>(a, b, c) + words[6] + 0xc040b340, 9) + a;
+        c = rotate<Tag>(c + f2<Tag>(d, a, b) + words[11] + 0x265e5a51, 14) + d;
+        b = rotate<Tag>(b + f2<Tag>(c, d, a) + words[0] + 0xe9b6c7aa, 20) + c;
+
+        a = rotate<Tag>(a + f2<Tag>(b, c, d) + words[5] + 0xd62f105d, 5) + b;
+        d = rotate<Tag>(d + f2<Tag>(a, b, c) + words[10] + 0x02441453, 9) + a;
+        c = rotate<Tag>(c + f2<Tag>(d, a, b) + words[15] + 0xd8a1e681, 14) + d;
+        b = rotate<Tag>(b + f2<Tag>(c, d, a) + words[4] + 0xe7d3fbc8, 20) + c;
+
+        a = rotate<Tag>(a + f2<Tag>(b, c, d) + words[9] + 0x21e1cde6, 5) + b;
+        d = rotate<Tag>(d + f2<Tag>(a, b, c) + words[14] + 0xc33707d6, 9) + a;
+        c = rotate<Tag>(c + f2<Tag>(d, a, b) + words[3] + 0xf4d50d87, 14) + d;
+        b = rotate<Tag>(b + f2<Tag>(c, d, a) + words[8] + 0x455a14ed, 20) + c;
+
+        a = rotate<Tag>(a + f2<Tag>(b, c, d) + words[13] + 0xa9e3e905, 5) + b;
+        d = rotate<Tag>(d + f2<Tag>(a, b, c) + words[2] + 0xfcefa3f8, 9) + a;
+        c = rotate<Tag>(c + f2<Tag>(d, a, b) + words[7] + 0x676f02d9, 14) + d;
+        b = rotate<Tag>(b + f2<Tag>(c, d, a) + words[12] + 0x8d2a4c8a, 20) + c;
+
+        // third round
+        a = rotate<Tag>(a + f3<Tag>(b, c, d) + words[5] + 0xfffa3942, 4) + b;
+        d = rotate<Tag>(d + f3<Tag>(a, b, c) + words[8] + 0x8771f681, 11) + a;
+        c = rotate<Tag>(c + f3<Tag>(d, a, b) + words[11] + 0x6d9d6122, 16) + d;
+        b = rotate<Tag>(b + f3<Tag>(c, d, a) + words[14] + 0xfde5380c, 23) + c;
+
+        a = rotate<Tag>(a + f3<Tag>(b, c, d) + words[1] + 0xa4beea44, 4) + b;
+        d = rotate<Tag>(d + f3<Tag>(a, b, c) + words[4] + 0x4bdecfa9, 11) + a;
+        c = rotate<Tag>(c + f3<Tag>(d, a, b) + words[7] + 0xf6bb4b60, 16) + d;
+        b = rotate<Tag>(b + f3<Tag>(c, d, a) + words[10] + 0xbebfbc70, 23) + c;
+
+        a = rotate<Tag>(a + f3<Tag>(b, c, d) + words[13] + 0x289b7ec6, 4) + b;
+        d = rotate<Tag>(d + f3<Tag>(a, b, c) + words[0] + 0xeaa127fa, 11) + a;
+        c = rotate<Tag>(c + f3<Tag>(d, a, b) + words[3] + 0xd4ef3085, 16) + d;
+        b = rotate<Tag>(b + f3<Tag>(c, d, a) + words[6] + 0x04881d05, 23) + c;
+
+        a = rotate<Tag>(a + f3<Tag>(b, c, d) + words[9] + 0xd9d4d039, 4) + b;
+        d = rotate<Tag>(d + f3<Tag>(a, b, c) + words[12] + 0xe6db99e5, 11) + a;
+        c = rotate<Tag>(c + f3<Tag>(d, a, b) + words[15] + 0x1fa27cf8, 16) + d;
+        b = rotate<Tag>(b + f3<Tag>(c, d, a) + words[2] + 0xc4ac5665, 23) + c;
+
+        // fourth round
+        a = rotate<Tag>(a + f4<Tag>(b, c, d) + words[0] + 0xf4292244, 6) + b;
+        d = rotate<Tag>(d + f4<Tag>(a, b, c) + words[7] + 0x432aff97, 10) + a;
+        c = rotate<Tag>(c + f4<Tag>(d, a, b) + words[14] + 0xab9423a7, 15) + d;
+        b = rotate<Tag>(b + f4<Tag>(c, d, a) + words[5] + 0xfc93a039, 21) + c;
+
+        a = rotate<Tag>(a + f4<Tag>(b, c, d) + words[12] + 0x655b59c3, 6) + b;
+        d = rotate<Tag>(d + f4<Tag>(a, b, c) + words[3] + 0x8f0ccc92, 10) + a;
+        c = rotate<Tag>(c + f4<Tag>(d, a, b) + words[10] + 0xffeff47d, 15) + d;
+        b = rotate<Tag>(b + f4<Tag>(c, d, a) + words[1] + 0x85845dd1, 21) + c;
+
+        a = rotate<Tag>(a + f4<Tag>(b, c, d) + words[8] + 0x6fa87e4f, 6) + b;
+        d = rotate<Tag>(d + f4<Tag>(a, b, c) + words[15] + 0xfe2ce6e0, 10) + a;
+        c = rotate<Tag>(c + f4<Tag>(d, a, b) + words[6] + 0xa3014314, 15) + d;
+        b = rotate<Tag>(b + f4<Tag>(c, d, a) + words[13] + 0x4e0811a1, 21) + c;
+
+        a = rotate<Tag>(a + f4<Tag>(b, c, d) + words[4] + 0xf7537e82, 6) + b;
+        d = rotate<Tag>(d + f4<Tag>(a, b, c) + words[11] + 0xbd3af235, 10) + a;
+        c = rotate<Tag>(c + f4<Tag>(d, a, b) + words[2] + 0x2ad7d2bb, 15) + d;
+        b = rotate<Tag>(b + f4<Tag>(c, d, a) + words[9] + 0xeb86d391, 21) + c;
+
+        hash[0] += a;
+        hash[1] += b;
+        hash[2] += c;
+        hash[3] += d;
+    }
+}
\ No newline at end of file
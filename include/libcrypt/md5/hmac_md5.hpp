@@ -0,0 +1,67 @@
+#pragma once
+
+#include "libcrypt/md5/md5.hpp"
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace libcrypt {
+    // HMAC-MD5 (RFC 2104).
+    // Inner and outer key blocks are hashed once by set_key() and their
+    // midstates restored for every message.
+    class hmac_md5 {
+    public:
+        using hash_t    = md5::hash_t;
+        using segment_t = md5::segment_t;
+
+    public:
+        hmac_md5();
+        hmac_md5(const hmac_md5&) = delete;
+        hmac_md5(hmac_md5&&)      = delete;
+
+        hmac_md5& operator=(const hmac_md5&) = delete;
+        hmac_md5& operator=(hmac_md5&&)      = delete;
+
+    public:
+        // Set key.
+        // Keys longer than 64 bytes are hashed first.
+        // Resets the incremental MAC.
+        void set_key(const void* key, size_t size);
+
+        // Set key
+        void set_key(const std::string& key);
+
+        // Compute MAC of the data.
+        // Doesn't touch the incremental MAC.
+        hash_t compute(const void* data, size_t size) const;
+
+        // Reset internal state for a new incremental MAC.
+        // Doesn't reset key.
+        void reset();
+
+        // Add data to the incremental MAC.
+        // Can be called any number of times before finalize().
+        void update(const void* data, size_t size);
+
+        // Finish the incremental MAC and return it.
+        // Internal state is reset afterwards.
+        hash_t finalize();
+
+        // Compute MACs of many messages.
+        // Results match compute() for each message and are returned in the same order.
+        std::vector<hash_t> compute_many(std::span<const segment_t> messages) const;
+
+    private:
+        inline static const size_t BLOCK_SIZE = 64;
+
+    private:
+        md5::state m_inner_state;
+        md5::state m_outer_state;
+        md5        m_inner;
+
+    private:
+        hash_t finalize(md5& inner) const;
+    };
+}
\ No newline at end of file
@@ -3,28 +3,98 @@
 
 #pragma once
 
+#include "libcrypt/misc/crypt_result.hpp"
+#include "libcrypt/misc/task.hpp"
+
+#include <filesystem>
 #include <array>
+#include <span>
 #include <string>
+#include <vector>
 #include <cstdint>
 
 namespace libcrypt {
     class md5 {
+    public:
+        using file_path_t = std::filesystem::path;
+        using segment_t   = std::span<const uint8_t>;
+        using hash_t      = std::array<uint8_t, 16>;
+
+        // Midstate of an incremental hash.
+        // Plain data, can be stored and restored with set_state() later.
+        struct state {
+            uint32_t hash[4];
+            uint64_t bytes;
+            uint8_t  buffer[64];
+            uint8_t  buffer_size;
+        };
+
     public:
         md5();
-        md5(const md5&) = delete;
-        md5(md5&&)      = delete;
 
-        md5& operator=(const md5&) = delete;
-        md5& operator=(md5&&)      = delete;
+        // Copies fork the incremental hash
+        md5(const md5&) = default;
+        md5(md5&&)      = default;
+
+        md5& operator=(const md5&) = default;
+        md5& operator=(md5&&)      = default;
 
     public:
         std::array<uint8_t, 16> compute(const void* data, size_t size);
         std::string to_string(const std::array<uint8_t, 16>& hash);
 
+        // Hash segments as one message.
+        // Result matches compute() of the concatenated segments, nothing is copied
+        // except partial blocks spanning segment boundaries.
+        std::array<uint8_t, 16> compute(std::span<const segment_t> segments);
+
+        // Hash the input file and save the digest to out.
+        // File is memory mapped where supported, otherwise read in chunks.
+        crypt_result compute_file(const file_path_t& input, std::array<uint8_t, 16>& out);
+
+        // Hash the input file one chunk at a time and save the digest to out.
+        // Suspends and resumes on exec after every chunk.
+        // Don't use this object or out until the task finishes.
+        task<crypt_result> compute_file_async(executor& exec, const file_path_t& input, std::array<uint8_t, 16>& out);
+
+        // Reset internal state for a new incremental hash.
+        void reset();
+
+        // Add data to the incremental hash.
+        // Can be called any number of times before finalize().
+        void update(const void* data, size_t size);
+
+        // Add segments to the incremental hash.
+        // Same as calling update() for each segment in order.
+        void update(std::span<const segment_t> segments);
+
+        // Finish the incremental hash and return the digest.
+        // Internal state is reset afterwards.
+        std::array<uint8_t, 16> finalize();
+
+        // Get midstate of the incremental hash
+        state get_state() const;
+
+        // Continue the incremental hash from a midstate.
+        // State must come from get_state().
+        void set_state(const state& state);
+
+        // Hash prefix followed by each suffix.
+        // Prefix is hashed once and its midstate forked for every suffix,
+        // results match compute() of the concatenated data.
+        std::vector<hash_t> compute_suffixes(segment_t prefix, std::span<const segment_t> suffixes);
+
+        // Hash many independent messages at once.
+        // Messages are hashed in parallel SIMD lanes of the active kernel, results match compute()
+        // for each message and are returned in the same order.
+        std::vector<std::array<uint8_t, 16>> compute_many(std::span<const std::span<const uint8_t>> messages);
+
     private:
         inline static const int BLOCK_SIZE = 64;
         inline static const int HASH_SIZE  = 16;
 
+        inline static const size_t FILE_CHUNK_SIZE = 1 << 20;
+
     private:
         uint64_t m_bytes;
         uint8_t  m_buffer[BLOCK_SIZE];
@@ -32,8 +102,9 @@ namespace libcrypt {
         uint32_t m_hash[HASH_SIZE / 4];
 
     private:
-        void reset();
         void process_block(const void* data);
         void process_buffer();
+
+        task<crypt_result> process_file_async(executor& exec, file_path_t input, std::array<uint8_t, 16>* out);
     };
 }
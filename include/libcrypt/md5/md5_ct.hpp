@@ -0,0 +1,66 @@
+#pragma once
+
+#include "libcrypt/md5/detail/md5_transform.hpp"
+
+#include <array>
+#include <string_view>
+#include <cstdint>
+
+namespace libcrypt {
+    // Compile time md5 of a string.
+    // Result matches md5::compute() of the same bytes.
+    // Uses the same rounds as the runtime path.
+    //   constexpr auto id = libcrypt::md5_ct("textures/foo.dds");
+    constexpr std::array<uint8_t, 16> md5_ct(std::string_view data) {
+        std::array<uint8_t, 16> digest{};
+
+        uint32_t hash[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+        uint32_t words[16]{};
+
+        uint64_t size   = data.size();
+        uint64_t blocks = (size + 8) / 64 + 1;
+
+        // Message, 0x80, zero padding and the bit length in the last block
+        for (uint64_t block = 0; block < blocks; block++) {
+            for (uint64_t i = 0; i < 16; i++) {
+                uint32_t word = 0U;
+
+                for (uint64_t j = 0; j < 4; j++) {
+                    uint64_t index = block * 64 + i * 4 + j;
+                    uint8_t  byte  = index < size ? (uint8_t)data[index] : index == size ? 0x80 : 0x00;
+
+                    word |= (uint32_t)byte << (8 * j);
+                }
+
+                words[i] = word;
+            }
+
+            if (block == blocks - 1) {
+                words[14] = (uint32_t)(size * 8);
+                words[15] = (uint32_t)((size * 8) >> 32);
+            }
+
+            detail::md5_transform(hash, words);
+        }
+
+        for (size_t i = 0; i < 16; i++)
+            digest[i] = (uint8_t)(hash[i / 4] >> (8 * (i % 4)));
+
+        return digest;
+    }
+
+    // Compile time counterpart of md5::to_string().
+    // Returns null terminated lowercase hex.
+    constexpr std::array<char, 33> md5_ct_to_string(const std::array<uint8_t, 16>& hash) {
+        constexpr char dec2hex[16 + 1] = "0123456789abcdef";
+
+        std::array<char, 33> result{};
+
+        for (size_t i = 0; i < 16; i++) {
+            result[2 * i]     = dec2hex[(hash[i] >> 4) & 15];
+            result[2 * i + 1] = dec2hex[hash[i] & 15];
+        }
+
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+
+#include <filesystem>
+#include <mutex>
+#include <array>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace libcrypt {
+    // On disk cache of md5 file digests.
+    // A cached digest is returned while the file's device, inode, size and
+    // modification time are unchanged, otherwise the file is hashed again.
+    // New digests are appended to the cache file, later records replace
+    // earlier ones for the same path.
+    // Safe to call from multiple threads.
+    class md5_digest_cache {
+    public:
+        using file_path_t = std::filesystem::path;
+        using hash_t      = std::array<uint8_t, 16>;
+
+        struct statistics {
+            uint64_t hits   = 0U;
+            uint64_t misses = 0U;
+        };
+
+    public:
+        md5_digest_cache();
+        md5_digest_cache(const md5_digest_cache&) = delete;
+        md5_digest_cache(md5_digest_cache&&)      = delete;
+
+        // Flushes new digests
+        ~md5_digest_cache();
+
+        md5_digest_cache& operator=(const md5_digest_cache&) = delete;
+        md5_digest_cache& operator=(md5_digest_cache&&)      = delete;
+
+    public:
+        // Load cache file, a missing file starts an empty cache.
+        // The file is memory mapped while reading where supported.
+        crypt_result open(const file_path_t& path);
+
+        // Flush and forget all digests
+        void close();
+
+        // Append new digests to the cache file
+        crypt_result flush();
+
+        // Rewrite the cache file with one record per path
+        crypt_result compact();
+
+        // Get number of cached digests
+        size_t get_count() const;
+
+        // Get hit and miss counts since open or reset
+        statistics get_statistics() const;
+
+        // Reset hit and miss counts
+        void reset_statistics();
+
+        // Get digest of the input file, hashing it if it changed.
+        // Same digest as md5::compute_file().
+        crypt_result compute_file(const file_path_t& input, hash_t& out);
+
+        // Get digests of all input files, changed files are hashed in parallel.
+        // 0 threads uses hardware concurrency.
+        // Fails if any file failed, its digest is left zeroed.
+        crypt_result compute_files(std::span<const file_path_t> inputs, std::vector<hash_t>& out, size_t thread_count = 0U);
+
+    private:
+        struct entry {
+            uint64_t device = 0U;
+            uint64_t inode  = 0U;
+            uint64_t size   = 0U;
+            int64_t  mtime  = 0;
+            hash_t   hash{};
+            bool     dirty  = false;
+        };
+
+    private:
+        mutable std::mutex                     m_mutex;
+        file_path_t                            m_path;
+        std::unordered_map<std::string, entry> m_entries;
+        statistics                             m_statistics;
+        bool                                   m_rewrite;
+
+    private:
+        // Get cached digest if current matches the stored identity
+        bool lookup(const std::string& key, const entry& current, hash_t& out);
+
+        // Hash input and cache the digest if current identity is known.
+        // Not cached if the file changed while it was hashed or too recently
+        // for its modification time to tell later writes apart.
+        crypt_result hash_file(const std::string& key, const file_path_t& input, const entry* current, hash_t& out);
+    };
+}
\ No newline at end of file
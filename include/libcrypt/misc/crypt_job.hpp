@@ -0,0 +1,99 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+
+#include <filesystem>
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace libcrypt {
+    // Hashes, encrypts or decrypts many files on a work-stealing thread pool.
+    // Each file is one task, largest files are queued first so a big file
+    // doesn't end up running alone at the end.
+    class crypt_job {
+    public:
+        using file_path_t = std::filesystem::path;
+
+        enum class operation : uint8_t {
+            hash,
+            encrypt,
+            decrypt
+        };
+
+        struct file_result {
+            file_path_t  input;
+            file_path_t  output;
+            crypt_result result;
+            uint64_t     size = 0U;
+
+            // Digest of the input, set for hash jobs
+            std::array<uint8_t, 16> hash{};
+        };
+
+        struct report {
+            std::vector<file_result> files;
+
+            size_t   failed           = 0U;
+            uint64_t total_size       = 0U;
+            double   seconds          = 0.0;
+            double   bytes_per_second = 0.0;
+        };
+
+    public:
+        crypt_job();
+        crypt_job(const crypt_job&) = delete;
+        crypt_job(crypt_job&&)      = delete;
+
+        crypt_job& operator=(const crypt_job&) = delete;
+        crypt_job& operator=(crypt_job&&)      = delete;
+
+    public:
+        // Set operation run on every file
+        void set_operation(operation op);
+
+        // Set key used by encrypt and decrypt jobs
+        void set_key(const std::string& key);
+
+        // Set iv used by encrypt and decrypt jobs
+        void set_iv(uint8_t iv);
+
+        // Set number of worker threads.
+        // 0 uses hardware concurrency.
+        void set_thread_count(size_t count);
+
+        // Add file.
+        // If output is empty, encrypt and decrypt results are saved to input.
+        void add_file(const file_path_t& input, const file_path_t& output = "");
+
+        // Add all regular files in the directory tree.
+        // If output is not empty, results are saved under it with the same
+        // relative paths, otherwise files are processed in place.
+        crypt_result add_directory(const file_path_t& input, const file_path_t& output = "");
+
+        // Remove all files
+        void clear();
+
+        // Get number of files
+        size_t get_count() const;
+
+        // Run operation on all files and wait for them to finish.
+        // Per file results are saved to out in the order files were added.
+        // Fails if any file failed.
+        crypt_result run(report& out);
+
+    private:
+        struct entry {
+            file_path_t input;
+            file_path_t output;
+        };
+
+    private:
+        operation          m_operation;
+        std::string        m_key;
+        uint8_t            m_iv;
+        size_t             m_thread_count;
+        std::vector<entry> m_entries;
+    };
+}
\ No newline at end of file
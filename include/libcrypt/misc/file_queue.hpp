@@ -0,0 +1,84 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+#include "libcrypt/rc4/rc4_key_schedule.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <array>
+#include <vector>
+#include <cstdint>
+
+namespace libcrypt {
+    // Hashes, encrypts and decrypts many files with several reads and writes
+    // in flight at once.
+    // Uses io_uring when built with CRYPT_IO_URING on Linux, otherwise
+    // pread/pwrite on a few worker threads. Blocks are hashed or crypted in order as their reads
+    // complete, while other reads and writes are still queued on the device.
+    // POSIX only, run() fails elsewhere.
+    class file_queue {
+    public:
+        using file_path_t      = std::filesystem::path;
+        using hash_callback_t  = std::function<void(const file_path_t& input, const crypt_result& result, const std::array<uint8_t, 16>& hash)>;
+        using crypt_callback_t = std::function<void(const file_path_t& input, const crypt_result& result)>;
+
+    public:
+        file_queue();
+        file_queue(const file_queue&) = delete;
+        file_queue(file_queue&&)      = delete;
+
+        file_queue& operator=(const file_queue&) = delete;
+        file_queue& operator=(file_queue&&)      = delete;
+
+    public:
+        // Set number of blocks in flight.
+        // Also limits the number of files open at once.
+        void set_queue_depth(size_t depth);
+
+        // Set size of each read and write
+        void set_block_size(size_t size);
+
+        // Get name of the backend used by the last run(), io_uring or pread
+        const char* get_backend() const;
+
+        // Queue md5 hash of input.
+        // Callback is called from run() when the file is done.
+        void hash_file_async(const file_path_t& input, hash_callback_t callback);
+
+        // Queue encryption of input to output.
+        // If output is empty, result will be saved to input.
+        // Callback is called from run() when the file is done.
+        void encrypt_file_async(rc4_key_schedule::ptr_t schedule, const file_path_t& input,
+            const file_path_t& output, crypt_callback_t callback);
+
+        // Queue decryption of input to output.
+        // If output is empty, result will be saved to input.
+        // Callback is called from run() when the file is done.
+        void decrypt_file_async(rc4_key_schedule::ptr_t schedule, const file_path_t& input,
+            const file_path_t& output, crypt_callback_t callback);
+
+        // Process all queued files and call their callbacks.
+        // Fails if the backend can't be set up or waited on, or any file failed.
+        crypt_result run();
+
+    private:
+        inline static const size_t DEFAULT_QUEUE_DEPTH = 32;
+        inline static const size_t DEFAULT_BLOCK_SIZE  = 256 << 10;
+
+    private:
+        struct request {
+            bool                    hash;
+            rc4_key_schedule::ptr_t schedule;
+            file_path_t             input;
+            file_path_t             output;
+            hash_callback_t         hash_callback;
+            crypt_callback_t        crypt_callback;
+        };
+
+    private:
+        size_t               m_queue_depth;
+        size_t               m_block_size;
+        const char*          m_backend;
+        std::vector<request> m_requests;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+
+#include <cstdint>
+
+namespace libcrypt {
+    // Instruction sets md5 and rc4 kernels are built for.
+    // Each level includes the ones below it.
+    enum class kernel_isa : uint8_t {
+        scalar,
+        sse2,
+        avx2,       // AVX2 with BMI1 and BMI2
+        avx512      // AVX-512F and AVX-512BW
+    };
+
+    // Runtime selection of md5 and rc4 kernels.
+    // CPU features are detected once on first use and the best supported kernels are picked.
+    // Setting LIBCRYPT_KERNEL environment variable to scalar, sse2, avx2 or avx512
+    // selects a lower level instead, unsupported values are ignored.
+    class kernels {
+    public:
+        kernels() = delete;
+
+    public:
+        // Get best isa supported by both the cpu and the build
+        static kernel_isa get_supported();
+
+        // Get isa of kernels currently in use
+        static kernel_isa get_active();
+
+        // Use kernels for isa.
+        // Fails if isa is above get_supported().
+        static crypt_result set_active(kernel_isa isa);
+
+        // Use kernels picked on startup
+        static void reset_active();
+
+        // Get isa name
+        static const char* to_string(kernel_isa isa);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace libcrypt {
+    // Schedules coroutines suspended by async operations.
+    // Implemented by the user to resume work on their own event loop or pool.
+    class executor {
+    public:
+        virtual ~executor() = default;
+
+    public:
+        // Resume handle later, from any thread
+        virtual void post(std::coroutine_handle<> handle) = 0;
+    };
+
+    // Suspend the current coroutine and resume it on exec
+    inline auto yield_to(executor& exec) {
+        struct awaiter {
+            executor& exec;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) const {
+                exec.post(handle);
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        return awaiter{ exec };
+    }
+
+    // Lazily started coroutine producing a T.
+    // Either co_await it from another coroutine or start() it and poll
+    // is_done() from the executor's loop.
+    // A started task can still be awaited, the awaiting coroutine resumes
+    // once it finishes.
+    template<typename T>
+    class task {
+    public:
+        struct promise_type {
+            std::optional<T>        value;
+            std::coroutine_handle<> continuation;
+            bool                    started = false;
+
+            // Set by whichever of the awaiter and the finished task comes
+            // first, the second one resumes the continuation
+            std::atomic<bool> handoff = false;
+
+            task get_return_object() {
+                return task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            auto final_suspend() noexcept {
+                struct awaiter {
+                    bool await_ready() const noexcept {
+                        return false;
+                    }
+
+                    // Continue the awaiting coroutine without growing the stack
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+                        auto& promise = handle.promise();
+
+                        if (!promise.handoff.exchange(true, std::memory_order_acq_rel))
+                            return std::noop_coroutine();
+
+                        return promise.continuation;
+                    }
+
+                    void await_resume() const noexcept {}
+                };
+
+                return awaiter{};
+            }
+
+            void return_value(T result) {
+                value = std::move(result);
+            }
+
+            void unhandled_exception() noexcept {
+                std::terminate();
+            }
+        };
+
+    public:
+        task(const task&) = delete;
+        task(task&& other) noexcept
+            : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+        ~task() {
+            if (m_handle)
+                m_handle.destroy();
+        }
+
+        task& operator=(const task&) = delete;
+        task& operator=(task&& other) noexcept {
+            if (this != &other) {
+                if (m_handle)
+                    m_handle.destroy();
+
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+
+            return *this;
+        }
+
+    public:
+        // Run until the first suspension.
+        // Does nothing if the task was already started or awaited.
+        void start() {
+            if (!m_handle || m_handle.promise().started)
+                return;
+
+            m_handle.promise().started = true;
+            m_handle.resume();
+        }
+
+        // Check if the coroutine has finished
+        bool is_done() const {
+            return !m_handle || m_handle.done();
+        }
+
+        // Get result, only valid once is_done()
+        T& get_result() {
+            return *m_handle.promise().value;
+        }
+
+    public:
+        // A started task may be running on another thread, so whether it
+        // finished is only decided by the handoff
+        bool await_ready() const noexcept {
+            return !m_handle;
+        }
+
+        // Unstarted tasks run now, started ones are only given the continuation
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+            auto& promise = m_handle.promise();
+            promise.continuation = continuation;
+
+            if (promise.handoff.exchange(true, std::memory_order_acq_rel))
+                return continuation;
+
+            if (promise.started)
+                return std::noop_coroutine();
+
+            promise.started = true;
+            return m_handle;
+        }
+
+        T await_resume() {
+            return std::move(*m_handle.promise().value);
+        }
+
+    private:
+        std::coroutine_handle<promise_type> m_handle;
+
+    private:
+        explicit task(std::coroutine_handle<promise_type> handle)
+            : m_handle(handle) {}
+    };
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+namespace libcrypt {
+    // Fixed size work-stealing thread pool.
+    // Each worker runs tasks from the back of its own queue, then takes
+    // external tasks in submission order and steals from the front of other
+    // queues when it runs dry.
+    // Tasks must not throw.
+    class thread_pool {
+    public:
+        using task_t = std::function<void()>;
+
+    public:
+        // 0 uses hardware concurrency
+        thread_pool(size_t thread_count = 0U);
+        thread_pool(const thread_pool&) = delete;
+        thread_pool(thread_pool&&)      = delete;
+
+        // Waits for queued tasks to finish
+        ~thread_pool();
+
+        thread_pool& operator=(const thread_pool&) = delete;
+        thread_pool& operator=(thread_pool&&)      = delete;
+
+    public:
+        // Get number of worker threads
+        size_t get_thread_count() const;
+
+        // Queue task.
+        // Tasks queued from a worker go to that worker's queue, others go to
+        // a shared queue and start in submission order.
+        void submit(task_t task);
+
+        // Wait until all queued tasks have finished.
+        // Must not be called from a task.
+        void wait();
+
+    private:
+        struct worker_queue {
+            std::mutex         mutex;
+            std::deque<task_t> tasks;
+        };
+
+    private:
+        std::vector<std::unique_ptr<worker_queue>> m_queues;
+        worker_queue                               m_injected;
+        std::vector<std::thread>                   m_threads;
+
+        std::mutex              m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        size_t                  m_queued;
+        size_t                  m_pending;
+        bool                    m_stopping;
+
+    private:
+        void run_worker(size_t index);
+
+        // Runs one task from the worker's queue, the shared queue or stolen
+        // from another worker.
+        // Returns false if all queues are empty.
+        bool run_one(size_t index);
+    };
+}
\ No newline at end of file
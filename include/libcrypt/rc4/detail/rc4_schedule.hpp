@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+// RC4 key schedule shared by the runtime and compile time paths.
+
+namespace libcrypt::detail {
+    // Key parsed the same way as rc4::set_key()
+    template<size_t N>
+    struct rc4_parsed_key {
+        char   data[N + 1]{};
+        size_t size = 0U;
+    };
+
+    constexpr int rc4_hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+
+        return -1;
+    }
+
+    constexpr bool rc4_is_hex_key(const char* key, size_t size) {
+        return size >= 2 && key[0] == '0' && (key[1] == 'x' || key[1] == 'X');
+    }
+
+    // Check that a hex key has only hex digits
+    constexpr bool rc4_is_valid_key(const char* key, size_t size) {
+        if (!rc4_is_hex_key(key, size))
+            return true;
+
+        for (size_t i = 2; i < size; i++) {
+            if (rc4_hex_value(key[i]) < 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    // Hex keys are decoded, odd digit counts get a leading zero
+    template<size_t N>
+    constexpr rc4_parsed_key<N> rc4_parse_key(const char* key) {
+        rc4_parsed_key<N> out;
+
+        if (!rc4_is_hex_key(key, N)) {
+            for (size_t i = 0; i < N; i++)
+                out.data[out.size++] = key[i];
+
+            return out;
+        }
+
+        size_t i = 2;
+
+        if ((N - 2) % 2 != 0)
+            out.data[out.size++] = (char)rc4_hex_value(key[i++]);
+
+        for (; i < N; i += 2)
+            out.data[out.size++] = (char)(rc4_hex_value(key[i]) * 16 + rc4_hex_value(key[i + 1]));
+
+        return out;
+    }
+
+    // Generates the initial box for key and iv
+    constexpr void rc4_generate_box(uint8_t* box, const char* key, size_t size, uint8_t iv) {
+        for (uint32_t i = 0; i < 256; i++) {
+            box[i] = (uint8_t)(iv ^ 0xFF);
+
+            iv = iv == 0xFF ? 0x00 : iv + 1;
+        }
+
+        // Only the first 255 bytes of longer keys are used
+        size_t mod = size <= 0xFF ? size : 0xFF;
+
+        uint32_t j = 0;
+        size_t   k = 0;
+
+        for (uint32_t i = 0; i < 256; i++) {
+            j = (j + box[i] + (uint8_t)(mod != 0 ? key[k] : 0)) & 0xFF;
+
+            if (++k == mod)
+                k = 0;
+
+            uint8_t temp = box[i];
+            box[i]       = box[j];
+            box[j]       = temp;
+        }
+    }
+
+    constexpr std::array<uint8_t, 256> rc4_generate_box(const char* key, size_t size, uint8_t iv) {
+        std::array<uint8_t, 256> box{};
+        rc4_generate_box(box.data(), key, size, iv);
+
+        return box;
+    }
+}
\ No newline at end of file
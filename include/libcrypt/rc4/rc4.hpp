@@ -1,8 +1,13 @@
 #pragma once
 
 #include "libcrypt/misc/crypt_result.hpp"
+#include "libcrypt/misc/task.hpp"
+#include "libcrypt/rc4/rc4_checkpoints.hpp"
+#include "libcrypt/rc4/rc4_key_schedule.hpp"
 
 #include <filesystem>
+#include <array>
+#include <span>
 #include <vector>
 #include <cstdint>
 
@@ -11,6 +16,14 @@ namespace libcrypt {
     public:
         using file_path_t = std::filesystem::path;
         using buffer_t    = std::vector<uint8_t>;
+        using hash_t      = std::array<uint8_t, 16>;
+        using segment_t   = std::span<uint8_t>;
+
+        // Data hashed by the fused crypt and hash functions
+        enum class hashed_data : uint8_t {
+            plaintext,
+            ciphertext
+        };
 
     public:
         rc4();
@@ -34,63 +47,220 @@ namespace libcrypt {
         // Set iv
         void set_iv(uint8_t iv);
 
+        // Set key, iv and initial box from a key schedule.
+        // Avoids generating the box for a key that's already scheduled.
+        // Resets the stream, the next crypt starts from the new key.
+        void set_key_schedule(const rc4_key_schedule& schedule);
+
         // Get current key
         const std::string& get_key() const;
 
         // Get current iv
         uint8_t get_iv() const;
 
+        // Builds checkpoints for the current key and iv covering the first
+        // length bytes of the stream, taking a snapshot every interval bytes.
+        crypt_result build_checkpoints(rc4_checkpoints& checkpoints, size_t length, size_t interval) const;
+
+        // Set size of chunks used when encrypting/decrypting file to file.
+        // Memory use is bounded by three chunks regardless of file size.
+        void set_chunk_size(size_t size);
+
+        // Get size of chunks used when encrypting/decrypting file to file
+        size_t get_chunk_size() const;
+
+        // Set checkpoints used by encrypt_stream/decrypt_stream to seek.
+        // Checkpoints must outlive this object or be unset by passing nullptr.
+        // Checkpoints built for a different key or iv are ignored.
+        void set_checkpoints(const rc4_checkpoints* checkpoints);
+
+        // Set number of stream positions kept by encrypt_stream/decrypt_stream,
+        // including the current one.
+        // A seek continues from the nearest kept position at or below the offset,
+        // so readers interleaving sequential reads of different regions don't
+        // walk the keystream from the start on every switch.
+        // Least recently used positions are dropped first. 0 is the same as 1.
+        void set_cursor_count(size_t count);
+
+        // Get number of stream positions kept by encrypt_stream/decrypt_stream
+        size_t get_cursor_count() const;
+
         // Preforms encryption on the input file and saves the encrypted data to
         // the output file.
         // If output is empty, result will be saved to input.
+        // In place files are memory mapped where supported, otherwise
+        // the file is processed in chunks, see set_chunk_size().
         crypt_result encrypt_file(const file_path_t& input, const file_path_t& output = "");
 
         // Preforms encryption on the input file and saves the encrypted data to
         // the out buffer.
         crypt_result encrypt_file(const file_path_t& input, buffer_t& out);
 
+        // Preforms encryption on the input file and saves the encrypted data to
+        // the output file one chunk at a time, see set_chunk_size().
+        // Suspends and resumes on exec after every chunk.
+        // If output is empty, result will be saved to input.
+        // Don't use this object until the task finishes.
+        task<crypt_result> encrypt_file_async(executor& exec, const file_path_t& input, const file_path_t& output = "");
+
         // Preforms encryption on the buffer.
         // Buffer content and size will be modified.
         crypt_result encrypt_buffer(buffer_t& buffer);
 
+        // Preforms encryption on the input buffer and saves the encrypted data to
+        // the out buffer.
+        // Input isn't modified, out is resized to input size.
+        crypt_result encrypt_buffer(const buffer_t& input, buffer_t& out);
+
+        // Preforms encryption of size bytes from src into dst.
+        // Src isn't modified, src and dst may be equal.
+        crypt_result encrypt_buffer(const uint8_t* src, uint8_t* dst, size_t size);
+
+        // Preforms encryption on the segments as one buffer.
+        // Keystream continues across segment boundaries, segments are
+        // crypted where they are.
+        crypt_result encrypt_buffer(std::span<const segment_t> segments);
+
+        // Preforms encryption on the buffer and md5 hashes it in the same pass.
+        // Each tile is hashed while it's still in cache, right before or after
+        // being encrypted. Hash matches md5::compute() of the hashed data.
+        // Buffer content and size will be modified.
+        crypt_result encrypt_buffer(buffer_t& buffer, hash_t& hash, hashed_data hashed = hashed_data::ciphertext);
+
         // Preforms encryption on the data.
         // Data is replaced with encrypted data.
         // Offset is offset from start of stream.
         // Call reset() after you finish encrypting.
         crypt_result encrypt_stream(uint8_t* ptr, size_t size, size_t offset);
 
+        // Preforms encryption of size bytes from src into dst.
+        // Src isn't modified, src and dst may be equal.
+        // Offset is offset from start of stream.
+        // Call reset() after you finish encrypting.
+        crypt_result encrypt_stream(const uint8_t* src, uint8_t* dst, size_t size, size_t offset);
+
+        // Preforms encryption on the segments as one range of the stream.
+        // Offset is offset of the first segment from start of stream.
+        // Call reset() after you finish encrypting.
+        crypt_result encrypt_stream(std::span<const segment_t> segments, size_t offset);
+
         // Preforms decryption on the input file and saves the data to
         // the output file.
         // If output is empty, result will be saved to input.
+        // In place files are memory mapped where supported, otherwise
+        // the file is processed in chunks, see set_chunk_size().
         crypt_result decrypt_file(const file_path_t& input, const file_path_t& output = "");
 
         // Preforms decryption on the input file and saves the data to
         // the out buffer.
         crypt_result decrypt_file(const file_path_t& input, buffer_t& out);
 
+        // Preforms decryption on the input file and saves the data to
+        // the output file one chunk at a time, see set_chunk_size().
+        // Suspends and resumes on exec after every chunk.
+        // If output is empty, result will be saved to input.
+        // Don't use this object until the task finishes.
+        task<crypt_result> decrypt_file_async(executor& exec, const file_path_t& input, const file_path_t& output = "");
+
         // Preforms decryption on the buffer.
         // Buffer content and size will be modified.
         crypt_result decrypt_buffer(buffer_t& buffer);
 
+        // Preforms decryption on the input buffer and saves the data to
+        // the out buffer.
+        // Input isn't modified, out is resized to input size.
+        crypt_result decrypt_buffer(const buffer_t& input, buffer_t& out);
+
+        // Preforms decryption of size bytes from src into dst.
+        // Src isn't modified, src and dst may be equal.
+        crypt_result decrypt_buffer(const uint8_t* src, uint8_t* dst, size_t size);
+
+        // Preforms decryption on the segments as one buffer.
+        // Keystream continues across segment boundaries, segments are
+        // crypted where they are.
+        crypt_result decrypt_buffer(std::span<const segment_t> segments);
+
+        // Preforms decryption on the buffer and verifies its md5 hash in the same pass.
+        // Fails if the hash of the hashed data doesn't match expected,
+        // buffer is decrypted either way.
+        crypt_result decrypt_buffer(buffer_t& buffer, const hash_t& expected, hashed_data hashed = hashed_data::ciphertext);
+
         // Preforms decryption on the data.
         // Data is replaced with decrypted data.
         // Offset is offset from start of stream.
         // Call reset() after you finish decrypting.
         crypt_result decrypt_stream(uint8_t* ptr, size_t size, size_t offset);
 
+        // Preforms decryption of size bytes from src into dst.
+        // Src isn't modified, src and dst may be equal.
+        // Offset is offset from start of stream.
+        // Call reset() after you finish decrypting.
+        crypt_result decrypt_stream(const uint8_t* src, uint8_t* dst, size_t size, size_t offset);
+
+        // Preforms decryption on the segments as one range of the stream.
+        // Offset is offset of the first segment from start of stream.
+        // Call reset() after you finish decrypting.
+        crypt_result decrypt_stream(std::span<const segment_t> segments, size_t offset);
+
+    protected:
+        // Set parsed key, iv and their initial box generated ahead of time.
+        // Box must be the key schedule of key and iv.
+        void set_key_schedule(const std::string& key, uint8_t iv, const uint8_t* box);
+
+    private:
+        inline static const size_t DEFAULT_CHUNK_SIZE   = 1 << 20;
+        inline static const size_t DEFAULT_CURSOR_COUNT = 4;
+
+        // Stream position parked by a seek
+        struct stream_cursor {
+            uint8_t  box[256];
+            uint32_t index_A;
+            uint32_t index_B;
+            uint64_t offset;
+            uint64_t last_used;
+        };
+
     private:
         bool        m_initialized;
         uint32_t    m_index_A;
         uint32_t    m_index_B;
         uint64_t    m_previous_offset;
         uint8_t     m_box[256];
+        uint8_t     m_initial_box[256];
+        bool        m_initial_box_valid;
         std::string m_key;
         uint8_t     m_iv;
 
+        const rc4_checkpoints* m_checkpoints;
+        size_t                 m_chunk_size;
+
+        std::vector<stream_cursor> m_cursors;
+        size_t                     m_cursor_count;
+        uint64_t                   m_cursor_clock;
+
     private:
         void generate_box();
 
+        // Get checkpoint nearest at or below offset.
+        // Returns nullptr if there are no checkpoints for the current key and iv.
+        const rc4_checkpoints::checkpoint* find_checkpoint(uint64_t offset, uint64_t& checkpoint_offset) const;
+
+        // Moves the stream state to offset, starting from the nearest of the
+        // current state, parked cursors, checkpoints and the initial box.
+        // Current state is parked if it isn't the one continued.
+        void seek(uint64_t offset);
+
+        // Keeps a copy of the current stream state, evicting the least
+        // recently used cursor if all are taken
+        void park_cursor();
+
+        crypt_result crypt_file(const file_path_t& input, const file_path_t& output);
+        crypt_result crypt_file(const file_path_t& input, buffer_t& out);
+        task<crypt_result> crypt_file_async(executor& exec, file_path_t input, file_path_t output);
         crypt_result crypt(rc4::buffer_t& buffer);
+        crypt_result crypt(rc4::buffer_t& buffer, hash_t& hash, bool hash_before);
         crypt_result crypt(uint8_t* ptr, size_t size, size_t offset = 0, bool keep_box = false);
+        crypt_result crypt(const uint8_t* src, uint8_t* dst, size_t size, size_t offset, bool keep_box);
+        crypt_result crypt(std::span<const segment_t> segments, size_t offset, bool keep_box);
     };
 }
\ No newline at end of file
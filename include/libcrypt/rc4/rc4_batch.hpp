@@ -0,0 +1,34 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+#include "libcrypt/rc4/rc4_key_schedule.hpp"
+
+#include <span>
+#include <string_view>
+#include <cstdint>
+
+namespace libcrypt {
+    // Crypts many independent buffers, each with its own key and iv.
+    // Several rc4 states are advanced in lockstep so their swap chains
+    // overlap instead of running one after another.
+    class rc4_batch {
+    public:
+        struct record {
+            // Key schedule to use, if null key and iv are scheduled in the batch
+            const rc4_key_schedule* schedule = nullptr;
+
+            // Key is parsed the same way as rc4::set_key()
+            std::string_view key = "";
+            uint8_t          iv  = 0U;
+
+            // Data is replaced with encrypted/decrypted data
+            uint8_t* ptr  = nullptr;
+            size_t   size = 0U;
+        };
+
+    public:
+        // Preforms encryption/decryption on all records.
+        // Equivalent to rc4::encrypt_buffer() with each record's key and iv.
+        static crypt_result crypt(std::span<record> records);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+
+#include <filesystem>
+#include <vector>
+#include <cstdint>
+
+namespace libcrypt {
+    class rc4;
+
+    // Snapshots of the rc4 keystream state taken every interval bytes.
+    // Built once per key/iv with rc4::build_checkpoints() and used by
+    // encrypt_stream/decrypt_stream to seek without walking from offset 0.
+    // Checkpoints are equivalent to the key, store them accordingly.
+    class rc4_checkpoints {
+    public:
+        using file_path_t = std::filesystem::path;
+
+        struct checkpoint {
+            uint8_t box[256];
+            uint8_t index_A;
+            uint8_t index_B;
+        };
+
+    public:
+        rc4_checkpoints();
+        rc4_checkpoints(const rc4_checkpoints&) = delete;
+        rc4_checkpoints(rc4_checkpoints&&)      = default;
+
+        rc4_checkpoints& operator=(const rc4_checkpoints&) = delete;
+        rc4_checkpoints& operator=(rc4_checkpoints&&)      = default;
+
+    public:
+        // Remove all checkpoints
+        void clear();
+
+        // Check if there are no checkpoints
+        bool empty() const;
+
+        // Get number of checkpoints
+        size_t get_count() const;
+
+        // Get distance in bytes between checkpoints
+        uint64_t get_interval() const;
+
+        // Get checkpoint nearest at or below offset.
+        // Checkpoint offset is set to the stream offset of the returned checkpoint.
+        // Returns nullptr if empty.
+        const checkpoint* find(uint64_t offset, uint64_t& checkpoint_offset) const;
+
+        // Save checkpoints to file
+        crypt_result save(const file_path_t& path) const;
+
+        // Load checkpoints from file
+        crypt_result load(const file_path_t& path);
+
+    private:
+        uint64_t                m_interval;
+        std::vector<checkpoint> m_checkpoints;
+
+    private:
+        friend class rc4;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+
+#include <filesystem>
+#include <array>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace libcrypt {
+    class mapped_file;
+
+    // Seekable encrypted container.
+    // Payload is split into fixed size blocks, each crypted with its own rc4
+    // state keyed by md5(key || iv || block index), so blocks can be
+    // encrypted/decrypted independently and in parallel.
+    //
+    // Layout (little endian):
+    //   "RC4B", u32 version, u32 block size, u32 reserved, u64 payload size,
+    //   md5 of every ciphertext block, ciphertext blocks.
+    //
+    // Block hashes detect corruption, not tampering, they aren't keyed.
+    class rc4_container {
+    public:
+        using file_path_t = std::filesystem::path;
+        using buffer_t    = std::vector<uint8_t>;
+        using hash_t      = std::array<uint8_t, 16>;
+
+    public:
+        rc4_container();
+        rc4_container(const rc4_container&) = delete;
+        rc4_container(rc4_container&&)      = delete;
+
+        ~rc4_container();
+
+        rc4_container& operator=(const rc4_container&) = delete;
+        rc4_container& operator=(rc4_container&&)      = delete;
+
+    public:
+        // Set key.
+        // Key is parsed the same way as rc4::set_key().
+        void set_key(const char* key, size_t size);
+
+        // Set key
+        void set_key(const std::string& key);
+
+        // Set iv
+        void set_iv(uint8_t iv);
+
+        // Set size of blocks written by encrypt functions.
+        // 0 uses the default size.
+        // Decryption uses the block size stored in the container.
+        void set_block_size(uint32_t size);
+
+        // Get size of blocks written by encrypt functions
+        uint32_t get_block_size() const;
+
+        // Set number of threads used to crypt blocks of whole files and buffers.
+        // 0 uses hardware concurrency.
+        void set_thread_count(size_t count);
+
+        // Preforms encryption on the input file and saves the container to
+        // the output file.
+        // Output must differ from input, it's replaced only on success.
+        crypt_result encrypt_file(const file_path_t& input, const file_path_t& output);
+
+        // Preforms encryption on the input buffer and saves the container to
+        // the out buffer.
+        crypt_result encrypt_buffer(const buffer_t& input, buffer_t& out);
+
+        // Preforms decryption on the input container file and saves the data to
+        // the output file.
+        // Output must differ from input, it's replaced only on success.
+        crypt_result decrypt_file(const file_path_t& input, const file_path_t& output);
+
+        // Preforms decryption on the input container buffer and saves the data to
+        // the out buffer.
+        crypt_result decrypt_buffer(const buffer_t& input, buffer_t& out);
+
+        // Open container file for random access reads.
+        // File is memory mapped where supported, otherwise read with stream IO.
+        crypt_result open(const file_path_t& path);
+
+        // Close opened container file
+        void close();
+
+        // Check if container file is open
+        bool is_open() const;
+
+        // Get payload size of opened container file
+        uint64_t get_size() const;
+
+        // Read and decrypt size bytes of payload at offset.
+        // Only blocks overlapping the range are hashed and decrypted.
+        // Can be called from several threads at once.
+        crypt_result read(uint8_t* ptr, size_t size, uint64_t offset);
+
+    private:
+        inline static const uint32_t DEFAULT_BLOCK_SIZE = 64 << 10;
+
+    private:
+        std::string m_key;
+        uint8_t     m_iv;
+        uint32_t    m_block_size;
+        size_t      m_thread_count;
+
+        // Opened container
+        std::unique_ptr<mapped_file> m_mapped;
+        std::ifstream                m_stream;
+        std::mutex                   m_stream_mutex;
+        std::vector<hash_t>          m_hashes;
+        uint32_t                     m_open_block_size;
+        uint64_t                     m_open_size;
+        bool                         m_open;
+
+    private:
+        // Crypts size bytes of payload split into blocks of block size.
+        // Hashes are of the ciphertext, written when encrypting and checked
+        // before decrypting.
+        crypt_result crypt_blocks(const uint8_t* src, uint8_t* dst, uint64_t size,
+            hash_t* hashes, uint32_t block_size, bool encrypt) const;
+
+        // Crypts the first size bytes of block index
+        void crypt_block(const uint8_t* src, uint8_t* dst, size_t size, uint64_t index) const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+#include "libcrypt/rc4/rc4_checkpoints.hpp"
+#include "libcrypt/rc4/rc4_key_schedule.hpp"
+
+#include <cstdint>
+
+namespace libcrypt {
+    // Position in the rc4 stream of a shared key schedule.
+    // Cheap to create and copy, each thread should use its own cursor.
+    class rc4_cursor {
+    public:
+        rc4_cursor(rc4_key_schedule::ptr_t schedule);
+
+    public:
+        // Move back to the start of the stream
+        void reset();
+
+        // Move to offset from start of stream.
+        // Seeking forward walks from the current position, seeking backwards
+        // restarts from the nearest checkpoint if provided or from the start.
+        void seek(uint64_t offset, const rc4_checkpoints* checkpoints = nullptr);
+
+        // Get offset from start of stream
+        uint64_t get_offset() const;
+
+        // Get key schedule
+        const rc4_key_schedule::ptr_t& get_schedule() const;
+
+        // Get current state as a checkpoint
+        rc4_checkpoints::checkpoint get_state() const;
+
+        // Set state from a checkpoint taken at offset.
+        // Checkpoint must belong to the same key schedule.
+        void set_state(const rc4_checkpoints::checkpoint& state, uint64_t offset);
+
+        // Preforms encryption/decryption on the data at the current offset.
+        // Data is replaced and the cursor advanced by size.
+        crypt_result crypt(uint8_t* ptr, size_t size);
+
+        // Preforms encryption/decryption of size bytes from src into dst at the
+        // current offset, src and dst may be equal.
+        // Cursor is advanced by size.
+        crypt_result crypt(const uint8_t* src, uint8_t* dst, size_t size);
+
+    private:
+        rc4_key_schedule::ptr_t m_schedule;
+        uint32_t                m_index_A;
+        uint32_t                m_index_B;
+        uint64_t                m_offset;
+        uint8_t                 m_box[256];
+    };
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace libcrypt {
+    // Immutable rc4 key schedule (initial box) for a key and iv.
+    // Safe to share between threads, streams are run with rc4_cursor.
+    class rc4_key_schedule {
+    public:
+        using ptr_t = std::shared_ptr<const rc4_key_schedule>;
+
+    public:
+        // Key is parsed the same way as rc4::set_key()
+        rc4_key_schedule(const char* key, size_t size, uint8_t iv);
+        rc4_key_schedule(const std::string& key, uint8_t iv);
+        rc4_key_schedule(const rc4_key_schedule&) = delete;
+        rc4_key_schedule(rc4_key_schedule&&)      = delete;
+
+        rc4_key_schedule& operator=(const rc4_key_schedule&) = delete;
+        rc4_key_schedule& operator=(rc4_key_schedule&&)      = delete;
+
+    public:
+        // Get shared schedule for key and iv from the process wide cache.
+        // Schedule is generated on first use. Thread safe.
+        static ptr_t get(const std::string& key, uint8_t iv);
+
+        // Remove all schedules from the process wide cache.
+        // Schedules still in use stay valid.
+        static void clear_cache();
+
+        // Get parsed key
+        const std::string& get_key() const;
+
+        // Get iv
+        uint8_t get_iv() const;
+
+        // Get initial box
+        const uint8_t* get_box() const;
+
+    private:
+        std::string m_key;
+        uint8_t     m_iv;
+        uint8_t     m_box[256];
+    };
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+#include "libcrypt/rc4/rc4_checkpoints.hpp"
+#include "libcrypt/rc4/rc4_key_schedule.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+namespace libcrypt {
+    class mapped_file;
+    class thread_pool;
+
+    // Precomputed keystream prefix for a key and iv.
+    // Crypting a range inside the prefix is a plain XOR that is split across
+    // a thread pool for large ranges. Ranges past the prefix continue from
+    // the furthest position crypted so far, or from the stored end state
+    // when reading before it.
+    // Keystream is equivalent to the key, store it accordingly.
+    class rc4_keystream_cache {
+    public:
+        using file_path_t = std::filesystem::path;
+
+    public:
+        rc4_keystream_cache();
+        rc4_keystream_cache(const rc4_keystream_cache&) = delete;
+        rc4_keystream_cache(rc4_keystream_cache&&)      = delete;
+
+        ~rc4_keystream_cache();
+
+        rc4_keystream_cache& operator=(const rc4_keystream_cache&) = delete;
+        rc4_keystream_cache& operator=(rc4_keystream_cache&&)      = delete;
+
+    public:
+        // Generate length bytes of keystream in memory
+        crypt_result build(rc4_key_schedule::ptr_t schedule, size_t length);
+
+        // Save keystream to file
+        crypt_result save(const file_path_t& path) const;
+
+        // Memory map keystream file saved for the same key schedule
+        crypt_result load(rc4_key_schedule::ptr_t schedule, const file_path_t& path);
+
+        // Release keystream
+        void clear();
+
+        // Get length of the cached keystream
+        size_t get_length() const;
+
+        // Set maximum number of threads used for large ranges.
+        // 0 uses hardware concurrency.
+        // Must not be called while crypting.
+        void set_thread_count(size_t count);
+
+        // Preforms encryption/decryption on the data.
+        // Data is replaced with encrypted/decrypted data.
+        // Offset is offset from start of stream.
+        // Safe to call from multiple threads.
+        crypt_result crypt(uint8_t* ptr, size_t size, uint64_t offset) const;
+
+        // Preforms encryption/decryption of size bytes from src into dst,
+        // src and dst may be equal.
+        // Offset is offset from start of stream.
+        // Safe to call from multiple threads.
+        crypt_result crypt(const uint8_t* src, uint8_t* dst, size_t size, uint64_t offset) const;
+
+    private:
+        rc4_key_schedule::ptr_t      m_schedule;
+        std::vector<uint8_t>         m_buffer;
+        std::unique_ptr<mapped_file> m_mapping;
+        const uint8_t*               m_keystream;
+        size_t                       m_length;
+        rc4_checkpoints::checkpoint  m_end_state;
+        size_t                       m_thread_count;
+
+        // Threads are started on the first large range
+        mutable std::mutex                   m_pool_mutex;
+        mutable std::unique_ptr<thread_pool> m_pool;
+
+        // Furthest position crypted past the prefix
+        mutable std::mutex                  m_tail_mutex;
+        mutable rc4_checkpoints::checkpoint m_tail_state;
+        mutable uint64_t                    m_tail_offset;
+    };
+}
\ No newline at end of file
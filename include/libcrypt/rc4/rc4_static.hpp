@@ -0,0 +1,55 @@
+#pragma once
+
+#include "libcrypt/rc4/rc4.hpp"
+#include "libcrypt/rc4/detail/rc4_schedule.hpp"
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace libcrypt {
+    // String literal usable as a template argument
+    template<size_t N>
+    struct fixed_string {
+        char value[N]{};
+
+        constexpr fixed_string(const char (&str)[N]) {
+            for (size_t i = 0; i < N; i++)
+                value[i] = str[i];
+        }
+
+        // Size without the null terminator
+        constexpr size_t size() const {
+            return N - 1;
+        }
+    };
+
+    namespace literals {
+        // "key"_k, same as passing "key" as the key template argument
+        template<fixed_string Key>
+        constexpr auto operator""_k() {
+            return Key;
+        }
+    }
+
+    // rc4 for a key and iv known at build time.
+    // Initial box is generated at compile time and stored as a constant,
+    // output is the same as rc4 with the same key and iv.
+    //   rc4_static<"key", 5> rc4;
+    template<fixed_string Key, uint8_t IV = 0U>
+    class rc4_static : public rc4 {
+    public:
+        static_assert(detail::rc4_is_valid_key(Key.value, Key.size()), "Hex key has non hex digits.");
+
+        // Key parsed the same way as rc4::set_key()
+        static constexpr auto key = detail::rc4_parse_key<Key.size()>(Key.value);
+
+        // Initial box for key and iv
+        static constexpr std::array<uint8_t, 256> box = detail::rc4_generate_box(key.data, key.size, IV);
+
+    public:
+        rc4_static() {
+            set_key_schedule(std::string(key.data, key.size), IV, box.data());
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "libcrypt/rc4/rc4.hpp"
+
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+#include <cstdint>
+
+namespace libcrypt {
+    // Stream buffer that decrypts data read from and encrypts data written to
+    // an inner stream buffer, through fixed size get and put areas.
+    // Positions are stream offsets, seeking maps onto rc4::decrypt_stream()
+    // and uses the checkpoints set on the rc4 object.
+    // Offset 0 is the inner buffer's position at construction, so data can
+    // follow a plain header.
+    // Switching between reading and writing requires a seekable inner buffer.
+    class rc4_streambuf : public std::streambuf {
+    public:
+        inline static const size_t DEFAULT_BUFFER_SIZE = 64 << 10;
+
+    public:
+        // Inner buffer and rc4 must outlive this object.
+        // rc4 is reset when this object is destroyed.
+        // which selects the inner position used as offset 0.
+        rc4_streambuf(std::streambuf* inner, rc4& rc4, size_t buffer_size = DEFAULT_BUFFER_SIZE,
+            std::ios_base::openmode which = std::ios_base::in | std::ios_base::out);
+        rc4_streambuf(const rc4_streambuf&) = delete;
+        rc4_streambuf(rc4_streambuf&&)      = delete;
+
+        // Flushes pending writes
+        ~rc4_streambuf() override;
+
+        rc4_streambuf& operator=(const rc4_streambuf&) = delete;
+        rc4_streambuf& operator=(rc4_streambuf&&)      = delete;
+
+    protected:
+        int_type underflow() override;
+        int_type overflow(int_type ch) override;
+        int sync() override;
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+    private:
+        std::streambuf*   m_inner;
+        rc4&              m_rc4;
+        std::vector<char> m_get;
+        std::vector<char> m_put;
+        std::vector<char> m_encrypted;
+
+        // Inner position of stream offset 0
+        uint64_t m_origin;
+
+        // Stream offset of the inner buffer's position
+        uint64_t m_position;
+
+    private:
+        // Encrypt and write the put area.
+        // Put area stays plaintext, on failure unwritten data is kept.
+        bool flush_put();
+
+        // Move the inner buffer back over read ahead data
+        bool drop_get();
+    };
+
+    // Input stream decrypting data read from an inner stream
+    class rc4_istream : public std::istream {
+    public:
+        // Inner stream and rc4 must outlive this object
+        rc4_istream(std::istream& inner, rc4& rc4, size_t buffer_size = rc4_streambuf::DEFAULT_BUFFER_SIZE);
+
+    private:
+        rc4_streambuf m_buffer;
+    };
+
+    // Output stream encrypting data written to an inner stream
+    class rc4_ostream : public std::ostream {
+    public:
+        // Inner stream and rc4 must outlive this object
+        rc4_ostream(std::ostream& inner, rc4& rc4, size_t buffer_size = rc4_streambuf::DEFAULT_BUFFER_SIZE);
+
+    private:
+        rc4_streambuf m_buffer;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "libcrypt/md5/hmac_md5.hpp"
+
+#include <cstring>
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+hmac_md5::hmac_md5() {
+    set_key(nullptr, 0U);
+}
+
+void hmac_md5::set_key(const void* key, size_t size) {
+    uint8_t block[BLOCK_SIZE]{};
+
+    if (size > BLOCK_SIZE) {
+        m_inner.reset();
+        m_inner.update(key, size);
+
+        auto digest = m_inner.finalize();
+        std::memcpy(block, digest.data(), digest.size());
+    }
+    else if (size != 0) {
+        std::memcpy(block, key, size);
+    }
+
+    uint8_t pad[BLOCK_SIZE];
+
+    for (size_t i = 0; i < BLOCK_SIZE; i++)
+        pad[i] = block[i] ^ 0x36;
+
+    m_inner.reset();
+    m_inner.update(pad, BLOCK_SIZE);
+    m_inner_state = m_inner.get_state();
+
+    for (size_t i = 0; i < BLOCK_SIZE; i++)
+        pad[i] = block[i] ^ 0x5C;
+
+    md5 outer;
+    outer.update(pad, BLOCK_SIZE);
+    m_outer_state = outer.get_state();
+
+    reset();
+}
+
+void hmac_md5::set_key(const std::string& key) {
+    set_key(key.data(), key.size());
+}
+
+hmac_md5::hash_t hmac_md5::compute(const void* data, size_t size) const {
+    // Separate inner hash, an incremental MAC in progress isn't disturbed
+    md5 inner;
+    inner.set_state(m_inner_state);
+    inner.update(data, size);
+
+    return finalize(inner);
+}
+
+void hmac_md5::reset() {
+    m_inner.set_state(m_inner_state);
+}
+
+void hmac_md5::update(const void* data, size_t size) {
+    m_inner.update(data, size);
+}
+
+hmac_md5::hash_t hmac_md5::finalize() {
+    hash_t mac = finalize(m_inner);
+
+    reset();
+
+    return mac;
+}
+
+std::vector<hmac_md5::hash_t> hmac_md5::compute_many(std::span<const segment_t> messages) const {
+    std::vector<hash_t> macs(messages.size());
+
+    for (size_t i = 0; i < messages.size(); i++)
+        macs[i] = compute(messages[i].data(), messages[i].size());
+
+    return macs;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+hmac_md5::hash_t hmac_md5::finalize(md5& inner) const {
+    hash_t digest = inner.finalize();
+
+    md5 outer;
+    outer.set_state(m_outer_state);
+    outer.update(digest.data(), digest.size());
+
+    return outer.finalize();
+}
\ No newline at end of file
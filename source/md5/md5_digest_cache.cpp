@@ -0,0 +1,443 @@
+#include "libcrypt/md5/md5_digest_cache.hpp"
+#include "libcrypt/md5/md5.hpp"
+#include "libcrypt/misc/thread_pool.hpp"
+#include "misc/mapped_file.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define LIBCRYPT_HAS_STAT
+
+    #include <sys/stat.h>
+#endif
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+// Record: device, inode, size, mtime, digest, path length, path
+static const char     CACHE_MAGIC[4]   = { 'M', 'D', '5', 'C' };
+static const uint32_t CACHE_VERSION    = 1U;
+static const size_t   CACHE_HEADER     = 8;
+static const size_t   CACHE_RECORD     = 8 + 8 + 8 + 8 + 16 + 4;
+static const int64_t  RACY_INTERVAL_NS = 1000000000;
+
+static std::string internal_key(const std::filesystem::path& path);
+static bool internal_identity(const std::filesystem::path& path, uint64_t& device, uint64_t& inode, uint64_t& size, int64_t& mtime);
+static int64_t internal_now();
+static uint64_t internal_read_uint(const uint8_t* ptr, size_t size);
+static void internal_write_uint(std::ostream& out, uint64_t value, size_t size);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+md5_digest_cache::md5_digest_cache() {
+    m_rewrite = false;
+}
+
+md5_digest_cache::~md5_digest_cache() {
+    close();
+}
+
+crypt_result md5_digest_cache::open(const file_path_t& path) {
+    crypt_result result;
+
+    close();
+
+    std::lock_guard lock(m_mutex);
+
+    m_path       = path;
+    m_statistics = statistics();
+
+    if (!std::filesystem::exists(path)) {
+        result.success = true;
+        return result;
+    }
+
+    mapped_file          mapping;
+    std::vector<uint8_t> buffer;
+    const uint8_t*       data = nullptr;
+    size_t               size = 0U;
+
+    if (mapping.open(path, false)) {
+        data = mapping.data();
+        size = mapping.size();
+    }
+    else {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            m_path.clear();
+            result.message = "Failed to open input file.";
+            return result;
+        }
+
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+    }
+
+    if (size < CACHE_HEADER || !std::equal(data, data + 4, CACHE_MAGIC) ||
+        internal_read_uint(data + 4, 4) != CACHE_VERSION)
+    {
+        m_path.clear();
+        result.message = "Invalid digest cache file.";
+        return result;
+    }
+
+    size_t position = CACHE_HEADER;
+
+    while (position + CACHE_RECORD <= size) {
+        const uint8_t* record = data + position;
+        size_t         length = (size_t)internal_read_uint(record + CACHE_RECORD - 4, 4);
+
+        if (length > size - position - CACHE_RECORD)
+            break;
+
+        entry value;
+        value.device = internal_read_uint(record, 8);
+        value.inode  = internal_read_uint(record + 8, 8);
+        value.size   = internal_read_uint(record + 16, 8);
+        value.mtime  = (int64_t)internal_read_uint(record + 24, 8);
+
+        std::copy(record + 32, record + 48, value.hash.begin());
+
+        m_entries[std::string((const char*)record + CACHE_RECORD, length)] = value;
+        position += CACHE_RECORD + length;
+    }
+
+    // Torn record from an interrupted write, appending after it would lose new records
+    m_rewrite = position != size;
+
+    result.success = true;
+    return result;
+}
+
+void md5_digest_cache::close() {
+    flush();
+
+    std::lock_guard lock(m_mutex);
+
+    m_path.clear();
+    m_entries.clear();
+    m_rewrite = false;
+}
+
+crypt_result md5_digest_cache::flush() {
+    crypt_result result;
+
+    std::unique_lock lock(m_mutex);
+
+    if (m_path.empty()) {
+        result.success = true;
+        return result;
+    }
+
+    if (m_rewrite) {
+        lock.unlock();
+        return compact();
+    }
+
+    bool exists = std::filesystem::exists(m_path);
+
+    std::ofstream out(m_path, std::ios::binary | std::ios::out | std::ios::app);
+    if (!out.is_open()) {
+        result.message = "Failed to open output file.";
+        return result;
+    }
+
+    if (!exists) {
+        out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        internal_write_uint(out, CACHE_VERSION, 4);
+    }
+
+    for (auto& [key, value] : m_entries) {
+        if (!value.dirty)
+            continue;
+
+        internal_write_uint(out, value.device, 8);
+        internal_write_uint(out, value.inode, 8);
+        internal_write_uint(out, value.size, 8);
+        internal_write_uint(out, (uint64_t)value.mtime, 8);
+        out.write((const char*)value.hash.data(), value.hash.size());
+        internal_write_uint(out, key.size(), 4);
+        out.write(key.data(), key.size());
+
+        value.dirty = false;
+    }
+
+    if (!out) {
+        result.message = "Failed to write output file.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+crypt_result md5_digest_cache::compact() {
+    crypt_result result;
+
+    std::lock_guard lock(m_mutex);
+
+    if (m_path.empty()) {
+        result.success = true;
+        return result;
+    }
+
+    // Written next to the cache and renamed over it
+    file_path_t temp_path = m_path;
+    temp_path += ".tmp";
+
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!out.is_open()) {
+            result.message = "Failed to open output file.";
+            return result;
+        }
+
+        out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        internal_write_uint(out, CACHE_VERSION, 4);
+
+        for (const auto& [key, value] : m_entries) {
+            internal_write_uint(out, value.device, 8);
+            internal_write_uint(out, value.inode, 8);
+            internal_write_uint(out, value.size, 8);
+            internal_write_uint(out, (uint64_t)value.mtime, 8);
+            out.write((const char*)value.hash.data(), value.hash.size());
+            internal_write_uint(out, key.size(), 4);
+            out.write(key.data(), key.size());
+        }
+
+        if (!out) {
+            result.message = "Failed to write output file.";
+            return result;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, m_path, error);
+
+    if (error) {
+        result.message = "Failed to write output file.";
+        return result;
+    }
+
+    for (auto& [key, value] : m_entries)
+        value.dirty = false;
+
+    m_rewrite      = false;
+    result.success = true;
+    return result;
+}
+
+size_t md5_digest_cache::get_count() const {
+    std::lock_guard lock(m_mutex);
+    return m_entries.size();
+}
+
+md5_digest_cache::statistics md5_digest_cache::get_statistics() const {
+    std::lock_guard lock(m_mutex);
+    return m_statistics;
+}
+
+void md5_digest_cache::reset_statistics() {
+    std::lock_guard lock(m_mutex);
+    m_statistics = statistics();
+}
+
+crypt_result md5_digest_cache::compute_file(const file_path_t& input, hash_t& out) {
+    crypt_result result;
+    std::string  key = internal_key(input);
+    entry        current;
+
+    bool known = internal_identity(input, current.device, current.inode, current.size, current.mtime);
+
+    if (known && lookup(key, current, out)) {
+        result.success = true;
+        return result;
+    }
+
+    return hash_file(key, input, known ? &current : nullptr, out);
+}
+
+crypt_result md5_digest_cache::compute_files(std::span<const file_path_t> inputs, std::vector<hash_t>& out, size_t thread_count) {
+    crypt_result result;
+
+    out.assign(inputs.size(), hash_t());
+
+    struct change {
+        size_t      index;
+        std::string key;
+        entry       current;
+        bool        known;
+    };
+
+    std::vector<crypt_result> results(inputs.size());
+    std::vector<change>       changed;
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        change item{ i, internal_key(inputs[i]) };
+
+        item.known = internal_identity(inputs[i], item.current.device, item.current.inode,
+            item.current.size, item.current.mtime);
+
+        if (item.known && lookup(item.key, item.current, out[i]))
+            results[i].success = true;
+        else
+            changed.push_back(std::move(item));
+    }
+
+    if (!changed.empty()) {
+        if (thread_count == 0U)
+            thread_count = std::max(1U, std::thread::hardware_concurrency());
+
+        thread_pool pool(std::min(thread_count, changed.size()));
+
+        for (const auto& item : changed) {
+            pool.submit([&]() {
+                results[item.index] = hash_file(item.key, inputs[item.index],
+                    item.known ? &item.current : nullptr, out[item.index]);
+            });
+        }
+
+        pool.wait();
+    }
+
+    size_t failed = (size_t)std::count_if(results.begin(), results.end(), [](const crypt_result& r) { return !r; });
+
+    if (failed != 0U) {
+        result.message = std::to_string(failed) + " files failed.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+bool md5_digest_cache::lookup(const std::string& key, const entry& current, hash_t& out) {
+    std::lock_guard lock(m_mutex);
+
+    auto it = m_entries.find(key);
+
+    bool hit = it != m_entries.end() &&
+        it->second.device == current.device && it->second.inode == current.inode &&
+        it->second.size   == current.size   && it->second.mtime == current.mtime;
+
+    if (!hit) {
+        m_statistics.misses++;
+        return false;
+    }
+
+    out = it->second.hash;
+    m_statistics.hits++;
+    return true;
+}
+
+crypt_result md5_digest_cache::hash_file(const std::string& key, const file_path_t& input, const entry* current, hash_t& out) {
+    md5 md5;
+
+    crypt_result result = md5.compute_file(input, out);
+    if (!result || !current)
+        return result;
+
+    // Skip files changed while hashing or too recently for mtime to show later writes
+    entry after;
+
+    if (!internal_identity(input, after.device, after.inode, after.size, after.mtime))
+        return result;
+
+    if (after.device != current->device || after.inode != current->inode ||
+        after.size   != current->size   || after.mtime != current->mtime ||
+        internal_now() - current->mtime < RACY_INTERVAL_NS)
+    {
+        return result;
+    }
+
+    after.hash  = out;
+    after.dirty = true;
+
+    std::lock_guard lock(m_mutex);
+    m_entries[key] = after;
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+std::string internal_key(const std::filesystem::path& path) {
+    std::error_code error;
+
+    auto absolute = std::filesystem::absolute(path, error);
+    return (error ? path : absolute).lexically_normal().generic_string();
+}
+
+bool internal_identity(const std::filesystem::path& path, uint64_t& device, uint64_t& inode, uint64_t& size, int64_t& mtime) {
+#if defined(LIBCRYPT_HAS_STAT)
+    struct stat info{};
+    if (::stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+        return false;
+
+    device = (uint64_t)info.st_dev;
+    inode  = (uint64_t)info.st_ino;
+    size   = (uint64_t)info.st_size;
+
+    #if defined(__APPLE__)
+    mtime = (int64_t)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+    #else
+    mtime = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+    #endif
+
+    return true;
+#else
+    // No inode, path and metadata only
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error))
+        return false;
+
+    auto time = std::filesystem::last_write_time(path, error);
+    size      = std::filesystem::file_size(path, error);
+
+    if (error)
+        return false;
+
+    device = 0U;
+    inode  = 0U;
+    mtime  = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+
+    return true;
+#endif
+}
+
+// Same clock as internal_identity() mtime
+int64_t internal_now() {
+#if defined(LIBCRYPT_HAS_STAT)
+    auto now = std::chrono::system_clock::now();
+#else
+    auto now = std::filesystem::file_time_type::clock::now();
+#endif
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+uint64_t internal_read_uint(const uint8_t* ptr, size_t size) {
+    uint64_t value = 0U;
+
+    for (size_t i = 0; i < size; i++)
+        value |= (uint64_t)ptr[i] << (8 * i);
+
+    return value;
+}
+
+void internal_write_uint(std::ostream& out, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        out.put((char)(value & 0xFF));
+        value >>= 8;
+    }
+}
\ No newline at end of file
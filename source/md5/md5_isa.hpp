@@ -0,0 +1,17 @@
+#pragma once
+
+#include "libcrypt/md5/detail/md5_transform.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// MD5 rounds for kernels built with their own isa flags.
+// The tag has internal linkage, so every TU including this gets a private
+// copy of the rounds built with its flags instead of a shared inline one.
+
+namespace {
+    struct md5_isa_tag {};
+}
+
+template<typename T>
+static inline void internal_md5_transform(T* hash, const T* words) {
+    libcrypt::detail::md5_transform<md5_isa_tag>(hash, words);
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "md5/md5_isa.hpp"
+
+#include <array>
+#include <span>
+#include <cstring>
+#include <cstdint>
+
+#ifndef _MSC_VER
+    #include <endian.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Multi-buffer md5, one message per vector lane.
+// Includers define LIBCRYPT_MD5_LANES and build with matching isa flags.
+
+#if !defined(LIBCRYPT_MD5_LANES)
+    #error LIBCRYPT_MD5_LANES must be defined
+#endif
+
+typedef uint32_t md5_lane_vector __attribute__((vector_size(LIBCRYPT_MD5_LANES * 4)));
+
+// One message being hashed in a lane.
+// Full blocks are read from data, the last one or two padded blocks from tail.
+struct md5_lane {
+    size_t         message = 0U;
+    const uint8_t* data    = nullptr;
+    uint64_t       block   = 0U;
+    uint64_t       full    = 0U;
+    uint64_t       blocks  = 0U;
+    uint8_t        tail[128];
+};
+
+static inline void internal_assign_lane(md5_lane& lane, size_t message, const std::span<const uint8_t>& data) {
+    uint64_t size      = data.size();
+    uint64_t remainder = size % 64;
+
+    lane.message = message;
+    lane.data    = data.data();
+    lane.block   = 0U;
+    lane.full    = size / 64;
+    lane.blocks  = lane.full + (remainder < 56 ? 1 : 2);
+
+    std::memset(lane.tail, 0, sizeof(lane.tail));
+    if (remainder)
+        std::memcpy(lane.tail, lane.data + lane.full * 64, remainder);
+
+    lane.tail[remainder] = 0x80;
+
+    uint64_t msg_bits = 8 * size;
+    uint8_t* length   = lane.tail + (lane.blocks - lane.full) * 64 - 8;
+
+    for (int i = 0; i < 8; i++) {
+        *length++ = msg_bits & 0xFF;
+        msg_bits >>= 8;
+    }
+}
+
+static inline const uint8_t* internal_lane_block(const md5_lane& lane) {
+    if (lane.block < lane.full)
+        return lane.data + lane.block * 64;
+
+    return lane.tail + (lane.block - lane.full) * 64;
+}
+
+static inline uint32_t internal_load_le32(const uint8_t* ptr) {
+#if defined(__BYTE_ORDER) && (__BYTE_ORDER != 0) && (__BYTE_ORDER == __BIG_ENDIAN)
+    return  (uint32_t)ptr[0]        |
+           ((uint32_t)ptr[1] << 8)  |
+           ((uint32_t)ptr[2] << 16) |
+           ((uint32_t)ptr[3] << 24);
+#else
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+#endif
+}
+
+static inline void internal_store_digest(const uint32_t* hash, std::array<uint8_t, 16>& digest) {
+    for (int i = 0; i < 4; i++) {
+        digest[i * 4 + 0] =  hash[i]        & 0xFF;
+        digest[i * 4 + 1] = (hash[i] >> 8)  & 0xFF;
+        digest[i * 4 + 2] = (hash[i] >> 16) & 0xFF;
+        digest[i * 4 + 3] = (hash[i] >> 24) & 0xFF;
+    }
+}
+
+// Hashes count messages, lanes refill as messages finish.
+static inline void internal_compute_lanes(const std::span<const uint8_t>* messages, size_t count,
+    std::array<uint8_t, 16>* digests)
+{
+    static const uint32_t INITIAL_HASH[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+    static const size_t   LANES           = LIBCRYPT_MD5_LANES;
+
+    md5_lane        lanes[LANES];
+    bool            active[LANES]{};
+    md5_lane_vector hash[4];
+    md5_lane_vector words[16];
+    uint32_t        transposed[16][LANES]{};
+
+    size_t next         = 0U;
+    size_t active_count = 0U;
+
+    auto assign_next = [&](size_t lane) {
+        active[lane] = next < count;
+        if (!active[lane])
+            return;
+
+        internal_assign_lane(lanes[lane], next, messages[next]);
+        next++;
+
+        for (int i = 0; i < 4; i++)
+            hash[i][lane] = INITIAL_HASH[i];
+    };
+
+    for (size_t lane = 0; lane < LANES; lane++) {
+        assign_next(lane);
+        active_count += active[lane];
+    }
+
+    // Run all lanes until only one message is left
+    while (active_count > 1) {
+        for (size_t lane = 0; lane < LANES; lane++) {
+            if (!active[lane])
+                continue;
+
+            const uint8_t* block = internal_lane_block(lanes[lane]);
+            for (int i = 0; i < 16; i++)
+                transposed[i][lane] = internal_load_le32(block + i * 4);
+        }
+
+        std::memcpy(words, transposed, sizeof(words));
+        internal_md5_transform(hash, words);
+
+        for (size_t lane = 0; lane < LANES; lane++) {
+            if (!active[lane] || ++lanes[lane].block != lanes[lane].blocks)
+                continue;
+
+            uint32_t lane_hash[4] = { hash[0][lane], hash[1][lane], hash[2][lane], hash[3][lane] };
+            internal_store_digest(lane_hash, digests[lanes[lane].message]);
+
+            assign_next(lane);
+            active_count -= !active[lane];
+        }
+    }
+
+    // Finish the last message on the scalar path
+    for (size_t lane = 0; lane < LANES; lane++) {
+        if (!active[lane])
+            continue;
+
+        uint32_t lane_hash[4] = { hash[0][lane], hash[1][lane], hash[2][lane], hash[3][lane] };
+        uint32_t lane_words[16];
+
+        for (; lanes[lane].block < lanes[lane].blocks; lanes[lane].block++) {
+            const uint8_t* block = internal_lane_block(lanes[lane]);
+            for (int i = 0; i < 16; i++)
+                lane_words[i] = internal_load_le32(block + i * 4);
+
+            internal_md5_transform(lane_hash, lane_words);
+        }
+
+        internal_store_digest(lane_hash, digests[lanes[lane].message]);
+    }
+}
\ No newline at end of file
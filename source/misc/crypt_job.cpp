@@ -0,0 +1,151 @@
+#include "libcrypt/misc/crypt_job.hpp"
+#include "libcrypt/misc/thread_pool.hpp"
+#include "libcrypt/md5/md5.hpp"
+#include "libcrypt/rc4/rc4.hpp"
+#include "libcrypt/rc4/rc4_key_schedule.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+crypt_job::crypt_job() {
+    m_operation    = operation::hash;
+    m_iv           = 0U;
+    m_thread_count = 0U;
+}
+
+void crypt_job::set_operation(operation op) {
+    m_operation = op;
+}
+
+void crypt_job::set_key(const std::string& key) {
+    m_key = key;
+}
+
+void crypt_job::set_iv(uint8_t iv) {
+    m_iv = iv;
+}
+
+void crypt_job::set_thread_count(size_t count) {
+    m_thread_count = count;
+}
+
+void crypt_job::add_file(const file_path_t& input, const file_path_t& output) {
+    m_entries.push_back({ input, output });
+}
+
+crypt_result crypt_job::add_directory(const file_path_t& input, const file_path_t& output) {
+    crypt_result result;
+    std::error_code error;
+
+    if (!std::filesystem::is_directory(input, error)) {
+        result.message = "Input directory not found.";
+        return result;
+    }
+
+    std::filesystem::recursive_directory_iterator it(input, error), end;
+
+    for (; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file(error))
+            continue;
+
+        if (output.empty())
+            add_file(it->path());
+        else
+            add_file(it->path(), output / std::filesystem::relative(it->path(), input));
+    }
+
+    if (error) {
+        result.message = "Failed to read input directory.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+void crypt_job::clear() {
+    m_entries.clear();
+}
+
+size_t crypt_job::get_count() const {
+    return m_entries.size();
+}
+
+crypt_result crypt_job::run(report& out) {
+    crypt_result result;
+
+    out = report();
+    out.files.resize(m_entries.size());
+
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        std::error_code error;
+
+        out.files[i].input  = m_entries[i].input;
+        out.files[i].output = m_entries[i].output;
+        out.files[i].size   = std::filesystem::file_size(m_entries[i].input, error);
+
+        if (error)
+            out.files[i].size = 0U;
+    }
+
+    // Largest first
+    std::vector<size_t> order(m_entries.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return out.files[a].size > out.files[b].size;
+    });
+
+    rc4_key_schedule::ptr_t schedule;
+    if (m_operation != operation::hash)
+        schedule = std::make_shared<const rc4_key_schedule>(m_key, m_iv);
+
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        thread_pool pool(m_thread_count);
+
+        for (size_t index : order) {
+            pool.submit([this, &schedule, &file = out.files[index]]() {
+                if (m_operation == operation::hash) {
+                    md5 md5;
+                    file.result = md5.compute_file(file.input, file.hash);
+                    return;
+                }
+
+                rc4 rc4;
+                rc4.set_key_schedule(*schedule);
+
+                if (m_operation == operation::encrypt)
+                    file.result = rc4.encrypt_file(file.input, file.output);
+                else
+                    file.result = rc4.decrypt_file(file.input, file.output);
+            });
+        }
+
+        pool.wait();
+    }
+
+    out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto& file : out.files) {
+        if (file.result) out.total_size += file.size;
+        else             out.failed++;
+    }
+
+    if (out.seconds > 0.0)
+        out.bytes_per_second = out.total_size / out.seconds;
+
+    if (out.failed != 0U) {
+        result.message = std::to_string(out.failed) + " files failed.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,374 @@
+#include "libcrypt/misc/file_queue.hpp"
+#include "libcrypt/md5/md5.hpp"
+#include "libcrypt/rc4/rc4_cursor.hpp"
+#include "misc/io_ring.hpp"
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define LIBCRYPT_HAS_PREAD
+
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+struct io_file;
+
+// One read or write buffer
+struct io_block {
+    io_file*             file    = nullptr;
+    std::vector<uint8_t> data;
+    uint64_t             offset  = 0U;
+    size_t               size    = 0U;
+    size_t               done    = 0U;
+    bool                 writing = false;
+};
+
+// File being processed.
+// Blocks are read out of order and hashed or crypted in order.
+struct io_file {
+    const void*                   request    = nullptr;
+    int                           in_fd      = -1;
+    int                           out_fd     = -1;
+    uint64_t                      size       = 0U;
+    uint64_t                      next_read  = 0U;
+    uint64_t                      next_crypt = 0U;
+    size_t                        blocks     = 0U;
+    std::map<uint64_t, io_block*> ready;
+    std::unique_ptr<md5>          hasher;
+    std::unique_ptr<rc4_cursor>   cursor;
+    crypt_result                  result;
+};
+
+static crypt_result internal_open(io_file& file, const std::filesystem::path& input, const std::filesystem::path& output);
+static void internal_close(io_file& file);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+file_queue::file_queue() {
+    m_queue_depth = DEFAULT_QUEUE_DEPTH;
+    m_block_size  = DEFAULT_BLOCK_SIZE;
+    m_backend     = "pread";
+}
+
+void file_queue::set_queue_depth(size_t depth) {
+    m_queue_depth = depth != 0U ? depth : DEFAULT_QUEUE_DEPTH;
+}
+
+void file_queue::set_block_size(size_t size) {
+    m_block_size = size != 0U ? size : DEFAULT_BLOCK_SIZE;
+}
+
+const char* file_queue::get_backend() const {
+    return m_backend;
+}
+
+void file_queue::hash_file_async(const file_path_t& input, hash_callback_t callback) {
+    m_requests.push_back({ true, nullptr, input, "", std::move(callback), nullptr });
+}
+
+void file_queue::encrypt_file_async(rc4_key_schedule::ptr_t schedule, const file_path_t& input,
+    const file_path_t& output, crypt_callback_t callback)
+{
+    m_requests.push_back({ false, std::move(schedule), input, output, nullptr, std::move(callback) });
+}
+
+void file_queue::decrypt_file_async(rc4_key_schedule::ptr_t schedule, const file_path_t& input,
+    const file_path_t& output, crypt_callback_t callback)
+{
+    // rc4 is symmetric
+    encrypt_file_async(std::move(schedule), input, output, std::move(callback));
+}
+
+crypt_result file_queue::run() {
+    crypt_result result;
+
+    std::vector<request> requests = std::move(m_requests);
+    m_requests.clear();
+
+    io_ring ring;
+    result = ring.open(m_queue_depth);
+    if (!result)
+        return result;
+
+    m_backend      = ring.get_backend();
+    result.success = false;
+
+    std::vector<io_block>  blocks(m_queue_depth);
+    std::vector<io_block*> free_blocks;
+
+    for (auto& block : blocks) {
+        block.data.resize(m_block_size);
+        free_blocks.push_back(&block);
+    }
+
+    std::list<io_file> files;
+    size_t             next   = 0U;
+    size_t             failed = 0U;
+
+    auto finish = [&](io_file& file) {
+        const request& req = *(const request*)file.request;
+
+        internal_close(file);
+
+        if (file.result.message.empty())
+            file.result.success = true;
+        else
+            failed++;
+
+        if (req.hash) {
+            std::array<uint8_t, 16> hash{};
+            if (file.result)
+                hash = file.hasher->finalize();
+
+            if (req.hash_callback)
+                req.hash_callback(req.input, file.result, hash);
+        }
+        else if (req.crypt_callback) {
+            req.crypt_callback(req.input, file.result);
+        }
+    };
+
+    auto release = [&](io_block* block) {
+        block->file->blocks--;
+        free_blocks.push_back(block);
+    };
+
+    auto fail = [&](io_file& file, const char* message) {
+        if (file.result.message.empty())
+            file.result.message = message;
+
+        for (auto& [offset, block] : file.ready)
+            release(block);
+
+        file.ready.clear();
+    };
+
+    while (true) {
+        // Open files up to the queue depth
+        while (files.size() < m_queue_depth && next < requests.size()) {
+            const request& req = requests[next++];
+
+            io_file& file = files.emplace_back();
+            file.request  = &req;
+            file.result   = internal_open(file, req.input, req.hash ? "" : (req.output.empty() ? req.input : req.output));
+
+            if (file.result) {
+                file.result.success = false;
+
+                if (req.hash)          file.hasher = std::make_unique<md5>();
+                else if (req.schedule) file.cursor = std::make_unique<rc4_cursor>(req.schedule);
+                else                   file.result.message = "Key schedule not set.";
+            }
+        }
+
+        // Spread free blocks across files
+        for (bool queued = true; queued && !free_blocks.empty();) {
+            queued = false;
+
+            for (auto& file : files) {
+                if (free_blocks.empty())
+                    break;
+
+                if (!file.result.message.empty() || file.next_read >= file.size)
+                    continue;
+
+                io_block* block = free_blocks.back();
+                free_blocks.pop_back();
+
+                block->file    = &file;
+                block->offset  = file.next_read;
+                block->size    = (size_t)std::min<uint64_t>(m_block_size, file.size - file.next_read);
+                block->done    = 0U;
+                block->writing = false;
+
+                file.next_read += block->size;
+                file.blocks++;
+
+                ring.read(file.in_fd, block->data.data(), block->size, block->offset, block);
+                queued = true;
+            }
+        }
+
+        // Finish files with nothing left in flight
+        for (auto it = files.begin(); it != files.end();) {
+            bool done = !it->result.message.empty() || it->next_crypt == it->size;
+
+            if (done && it->blocks == 0U) {
+                finish(*it);
+                it = files.erase(it);
+            }
+            else {
+                it++;
+            }
+        }
+
+        if (files.empty() && next == requests.size())
+            break;
+
+        // A ring that can't be waited on won't make progress, fail the files
+        // still open and those never started
+        io_ring::completion completion;
+        crypt_result waited = ring.wait(completion);
+        if (!waited) {
+            ring.close();
+
+            for (auto& file : files) {
+                fail(file, waited.message.c_str());
+                finish(file);
+            }
+
+            for (; next < requests.size(); next++) {
+                const request& req = requests[next];
+
+                if (req.hash && req.hash_callback)         req.hash_callback(req.input, waited, {});
+                else if (!req.hash && req.crypt_callback) req.crypt_callback(req.input, waited);
+            }
+
+            return waited;
+        }
+
+        io_block* block = (io_block*)completion.user;
+        io_file&  file  = *block->file;
+
+        if (!file.result.message.empty()) {
+            release(block);
+            continue;
+        }
+
+        if (completion.result <= 0) {
+            release(block);
+            fail(file, block->writing ? "Failed to write output file." : "Failed to read input file.");
+            continue;
+        }
+
+        // Short transfers are continued
+        block->done += (size_t)completion.result;
+        if (block->done < block->size) {
+            uint8_t* ptr    = block->data.data() + block->done;
+            size_t   size   = block->size - block->done;
+            uint64_t offset = block->offset + block->done;
+
+            if (block->writing) ring.write(file.out_fd, ptr, size, offset, block);
+            else                ring.read(file.in_fd, ptr, size, offset, block);
+
+            continue;
+        }
+
+        if (block->writing) {
+            release(block);
+            continue;
+        }
+
+        file.ready[block->offset] = block;
+
+        while (!file.ready.empty() && file.ready.begin()->first == file.next_crypt) {
+            io_block* current = file.ready.begin()->second;
+            file.ready.erase(file.ready.begin());
+
+            file.next_crypt += current->size;
+
+            if (file.hasher) {
+                file.hasher->update(current->data.data(), current->size);
+                release(current);
+                continue;
+            }
+
+            file.cursor->crypt(current->data.data(), current->size);
+
+            current->done    = 0U;
+            current->writing = true;
+
+            ring.write(file.out_fd, current->data.data(), current->size, current->offset, current);
+        }
+    }
+
+    if (failed != 0U) {
+        result.message = std::to_string(failed) + " files failed.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+crypt_result internal_open(io_file& file, const std::filesystem::path& input, const std::filesystem::path& output) {
+    crypt_result result;
+
+    if (!std::filesystem::exists(input)) {
+        result.message = "Input file not found.";
+        return result;
+    }
+
+#if defined(LIBCRYPT_HAS_PREAD)
+    // Output is empty for read only files
+    std::error_code error;
+    bool writable = !output.empty();
+    bool in_place = writable && std::filesystem::equivalent(input, output, error);
+
+    file.in_fd = ::open(input.c_str(), in_place ? O_RDWR : O_RDONLY);
+    if (file.in_fd == -1) {
+        result.message = "Failed to open input file.";
+        return result;
+    }
+
+    struct stat info{};
+    if (fstat(file.in_fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        internal_close(file);
+        result.message = "Failed to open input file.";
+        return result;
+    }
+
+    file.size = (uint64_t)info.st_size;
+
+    if (in_place) {
+        file.out_fd = file.in_fd;
+    }
+    else if (writable) {
+        if (output.has_parent_path())
+            std::filesystem::create_directories(output.parent_path(), error);
+
+        file.out_fd = ::open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (file.out_fd == -1) {
+            internal_close(file);
+            result.message = "Failed to open output file.";
+            return result;
+        }
+    }
+
+    result.success = true;
+#else
+    (void)file;
+    (void)output;
+
+    result.message = "Asynchronous file IO not supported.";
+#endif
+
+    return result;
+}
+
+void internal_close(io_file& file) {
+#if defined(LIBCRYPT_HAS_PREAD)
+    if (file.out_fd != -1 && file.out_fd != file.in_fd)
+        ::close(file.out_fd);
+
+    if (file.in_fd != -1)
+        ::close(file.in_fd);
+#endif
+
+    file.in_fd  = -1;
+    file.out_fd = -1;
+}
\ No newline at end of file
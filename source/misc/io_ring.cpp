@@ -0,0 +1,291 @@
+#include "misc/io_ring.hpp"
+#include "libcrypt/misc/thread_pool.hpp"
+
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define LIBCRYPT_HAS_PREAD
+
+    #include <cerrno>
+    #include <unistd.h>
+#endif
+
+#if defined(LIBCRYPT_IO_URING)
+    #include <liburing.h>
+#endif
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+static int64_t internal_pread(int fd, void* buffer, size_t size, uint64_t offset);
+static int64_t internal_pwrite(int fd, const void* buffer, size_t size, uint64_t offset);
+
+#if defined(LIBCRYPT_IO_URING)
+// Returns nullptr if the submission queue is still full after submitting
+static io_uring_sqe* internal_get_sqe(io_uring* ring);
+static int internal_wait_cqe(io_uring* ring, io_uring_cqe** cqe);
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+io_ring::io_ring() {
+    m_ring      = nullptr;
+    m_in_flight = 0U;
+}
+
+io_ring::~io_ring() {
+    close();
+}
+
+crypt_result io_ring::open(size_t depth) {
+    crypt_result result;
+
+    close();
+
+#if defined(LIBCRYPT_HAS_PREAD)
+    #if defined(LIBCRYPT_IO_URING)
+    // Falls back to pread/pwrite if io_uring is disabled or blocked
+    m_ring = new io_uring();
+
+    if (io_uring_queue_init((unsigned)depth, m_ring, 0) != 0) {
+        delete m_ring;
+        m_ring = nullptr;
+    }
+    #endif
+
+    if (!m_ring)
+        m_pool = std::make_unique<thread_pool>(std::clamp<size_t>(depth, 1U, MAX_THREADS));
+
+    result.success = true;
+#else
+    (void)depth;
+
+    result.message = "Asynchronous file IO not supported.";
+#endif
+
+    return result;
+}
+
+void io_ring::close() {
+#if defined(LIBCRYPT_IO_URING)
+    if (m_ring) {
+        // Buffers of requests in flight belong to the caller, so they have to
+        // complete before it frees them
+        for (; m_in_flight != 0U; m_in_flight--) {
+            io_uring_cqe* cqe = nullptr;
+            if (internal_wait_cqe(m_ring, &cqe) < 0)
+                break;
+
+            io_uring_cqe_seen(m_ring, cqe);
+        }
+
+        io_uring_queue_exit(m_ring);
+        delete m_ring;
+    }
+#endif
+
+    // Waits for requests running on the pool
+    m_pool.reset();
+
+    m_ring      = nullptr;
+    m_in_flight = 0U;
+    m_completed.clear();
+}
+
+const char* io_ring::get_backend() const {
+    return m_ring ? "io_uring" : "pread";
+}
+
+void io_ring::read(int fd, void* buffer, size_t size, uint64_t offset, void* user) {
+#if defined(LIBCRYPT_IO_URING)
+    if (m_ring) {
+        io_uring_sqe* sqe = internal_get_sqe(m_ring);
+
+        // Submission queue stays full, the request runs inline below
+        if (sqe) {
+                io_uring_prep_read(sqe, fd, buffer, (unsigned)size, offset);
+            io_uring_sqe_set_data(sqe, user);
+
+            m_in_flight++;
+            return;
+        }
+    }
+#endif
+
+    dispatch(false, fd, buffer, size, offset, user);
+}
+
+void io_ring::write(int fd, const void* buffer, size_t size, uint64_t offset, void* user) {
+#if defined(LIBCRYPT_IO_URING)
+    if (m_ring) {
+        io_uring_sqe* sqe = internal_get_sqe(m_ring);
+
+        // Submission queue stays full, the request runs inline below
+        if (sqe) {
+                io_uring_prep_write(sqe, fd, buffer, (unsigned)size, offset);
+            io_uring_sqe_set_data(sqe, user);
+
+            m_in_flight++;
+            return;
+        }
+    }
+#endif
+
+    dispatch(true, fd, (void*)buffer, size, offset, user);
+}
+
+crypt_result io_ring::wait(completion& out) {
+    crypt_result result;
+
+    if (m_in_flight == 0U) {
+        result.message = "No file IO in flight.";
+        return result;
+    }
+
+    // Requests run inline are reported before the ring is waited on
+    {
+        std::unique_lock lock(m_mutex);
+
+        if (!m_ring)
+            m_wake.wait(lock, [this]() { return !m_completed.empty(); });
+
+        if (!m_completed.empty()) {
+            out = m_completed.front();
+            m_completed.pop_front();
+            m_in_flight--;
+
+            result.success = true;
+            return result;
+        }
+    }
+
+#if defined(LIBCRYPT_IO_URING)
+    if (m_ring) {
+        io_uring_cqe* cqe = nullptr;
+
+        if (internal_wait_cqe(m_ring, &cqe) < 0) {
+            result.message = "Failed to wait for file IO.";
+            return result;
+        }
+
+        out.user   = io_uring_cqe_get_data(cqe);
+        out.result = cqe->res;
+
+        io_uring_cqe_seen(m_ring, cqe);
+        m_in_flight--;
+
+        result.success = true;
+        return result;
+    }
+#endif
+
+    result.message = "Failed to wait for file IO.";
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+void io_ring::dispatch(bool write, int fd, void* buffer, size_t size, uint64_t offset, void* user) {
+    m_in_flight++;
+
+    auto run = [this, write, fd, buffer, size, offset, user]() {
+        int64_t result = write ? internal_pwrite(fd, buffer, size, offset) : internal_pread(fd, buffer, size, offset);
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_completed.push_back({ user, result });
+        }
+
+        m_wake.notify_one();
+    };
+
+    if (m_pool) m_pool->submit(std::move(run));
+    else        run();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+int64_t internal_pread(int fd, void* buffer, size_t size, uint64_t offset) {
+#if defined(LIBCRYPT_HAS_PREAD)
+    size_t done = 0U;
+
+    while (done < size) {
+        ssize_t count = ::pread(fd, (uint8_t*)buffer + done, size - done, (off_t)(offset + done));
+
+        if (count < 0 && errno == EINTR)
+            continue;
+
+        if (count < 0)
+            return -errno;
+
+        if (count == 0)
+            break;
+
+        done += (size_t)count;
+    }
+
+    return (int64_t)done;
+#else
+    (void)fd;
+    (void)buffer;
+    (void)size;
+    (void)offset;
+
+    return -1;
+#endif
+}
+
+int64_t internal_pwrite(int fd, const void* buffer, size_t size, uint64_t offset) {
+#if defined(LIBCRYPT_HAS_PREAD)
+    size_t done = 0U;
+
+    while (done < size) {
+        ssize_t count = ::pwrite(fd, (const uint8_t*)buffer + done, size - done, (off_t)(offset + done));
+
+        if (count < 0 && errno == EINTR)
+            continue;
+
+        if (count <= 0)
+            return count < 0 ? -errno : (int64_t)done;
+
+        done += (size_t)count;
+    }
+
+    return (int64_t)done;
+#else
+    (void)fd;
+    (void)buffer;
+    (void)size;
+    (void)offset;
+
+    return -1;
+#endif
+}
+
+#if defined(LIBCRYPT_IO_URING)
+io_uring_sqe* internal_get_sqe(io_uring* ring) {
+    io_uring_sqe* sqe = io_uring_get_sqe(ring);
+
+    if (!sqe && io_uring_submit(ring) >= 0)
+        sqe = io_uring_get_sqe(ring);
+
+    return sqe;
+}
+
+int internal_wait_cqe(io_uring* ring, io_uring_cqe** cqe) {
+    // Submits anything still queued, interrupted waits are retried
+    while (true) {
+        int error = io_uring_submit_and_wait(ring, 1);
+        if (error >= 0)
+            error = io_uring_wait_cqe(ring, cqe);
+
+        if (error != -EINTR)
+            return error;
+    }
+}
+#endif
\ No newline at end of file
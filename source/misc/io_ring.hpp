@@ -0,0 +1,76 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+struct io_uring;
+
+namespace libcrypt {
+    class thread_pool;
+
+    // Queue of positional file reads and writes.
+    // Uses io_uring when built with CRYPT_IO_URING and the kernel allows it,
+    // otherwise requests run with pread/pwrite on a small thread pool so they
+    // are still in flight together.
+    // POSIX only, open() fails elsewhere.
+    class io_ring {
+    public:
+        struct completion {
+            void*   user   = nullptr;
+            int64_t result = 0;     // bytes transferred or -errno
+        };
+
+    public:
+        io_ring();
+        io_ring(const io_ring&) = delete;
+        io_ring(io_ring&&)      = delete;
+
+        ~io_ring();
+
+        io_ring& operator=(const io_ring&) = delete;
+        io_ring& operator=(io_ring&&)      = delete;
+
+    public:
+        // Set up a ring for depth requests in flight
+        crypt_result open(size_t depth);
+
+        // Tear down the ring.
+        // Waits for requests in flight, their completions are dropped.
+        void close();
+
+        // Get name of the backend in use
+        const char* get_backend() const;
+
+        // Queue read, submitted no later than the next wait()
+        void read(int fd, void* buffer, size_t size, uint64_t offset, void* user);
+
+        // Queue write, submitted no later than the next wait()
+        void write(int fd, const void* buffer, size_t size, uint64_t offset, void* user);
+
+        // Submit queued requests and wait for one to complete.
+        // Fails if nothing is in flight or the ring can't be waited on.
+        crypt_result wait(completion& out);
+
+    private:
+        inline static const size_t MAX_THREADS = 16;
+
+    private:
+        io_uring*                    m_ring;
+        size_t                       m_in_flight;
+        std::unique_ptr<thread_pool> m_pool;
+
+        // Completions from the pread/pwrite threads
+        std::mutex              m_mutex;
+        std::condition_variable m_wake;
+        std::deque<completion>  m_completed;
+
+    private:
+        // Runs a pread/pwrite request on the pool, or inline without one
+        void dispatch(bool write, int fd, void* buffer, size_t size, uint64_t offset, void* user);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <cstdint>
+
+namespace libcrypt {
+    // Kernels built for one isa.
+    // Entries are nullptr when the isa adds nothing over the level below or
+    // the build can't target it, the level below is used instead.
+    struct kernel_table {
+        // Compresses one block of 16 native endian words into hash
+        void (*md5_block)(uint32_t* hash, const uint32_t* words);
+
+        // Hashes count messages in parallel lanes
+        void (*md5_lanes)(const std::span<const uint8_t>* messages, size_t count, std::array<uint8_t, 16>* digests);
+
+        // XORs size bytes of keystream with src into dst, src and dst may be equal
+        void (*rc4_xor)(const uint8_t* src, const uint8_t* keystream, uint8_t* dst, size_t size);
+
+        // Get kernels for the active isa, all entries are set
+        static const kernel_table& get();
+    };
+
+    extern const kernel_table KERNELS_SCALAR;
+    extern const kernel_table KERNELS_SSE2;
+    extern const kernel_table KERNELS_AVX2;
+    extern const kernel_table KERNELS_AVX512;
+}
\ No newline at end of file
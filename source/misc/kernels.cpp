@@ -0,0 +1,185 @@
+#include "libcrypt/misc/kernels.hpp"
+#include "misc/kernel_table.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define LIBCRYPT_X86
+
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+static const size_t ISA_COUNT = (size_t)kernel_isa::avx512 + 1;
+
+// Kernels for each isa with empty entries filled from the level below
+struct kernel_registry {
+    kernel_table            tables[ISA_COUNT];
+    kernel_isa              supported;
+    kernel_isa              startup;
+    std::atomic<kernel_isa> active;
+
+    kernel_registry();
+};
+
+static kernel_registry& internal_registry();
+static kernel_isa internal_detect();
+static bool internal_built(const kernel_table& table);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+kernel_isa kernels::get_supported() {
+    return internal_registry().supported;
+}
+
+kernel_isa kernels::get_active() {
+    return internal_registry().active.load(std::memory_order_relaxed);
+}
+
+crypt_result kernels::set_active(kernel_isa isa) {
+    crypt_result result;
+    auto& registry = internal_registry();
+
+    if (isa > registry.supported) {
+        result.message = "Kernel not supported.";
+        return result;
+    }
+
+    registry.active.store(isa, std::memory_order_relaxed);
+
+    result.success = true;
+    return result;
+}
+
+void kernels::reset_active() {
+    auto& registry = internal_registry();
+    registry.active.store(registry.startup, std::memory_order_relaxed);
+}
+
+const char* kernels::to_string(kernel_isa isa) {
+    switch (isa) {
+        case kernel_isa::scalar: return "scalar";
+        case kernel_isa::sse2:   return "sse2";
+        case kernel_isa::avx2:   return "avx2";
+        case kernel_isa::avx512: return "avx512";
+        default:                 return "";
+    }
+}
+
+const kernel_table& kernel_table::get() {
+    auto& registry = internal_registry();
+    return registry.tables[(size_t)registry.active.load(std::memory_order_relaxed)];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+kernel_registry::kernel_registry() {
+    const kernel_table* built[ISA_COUNT] = { &KERNELS_SCALAR, &KERNELS_SSE2, &KERNELS_AVX2, &KERNELS_AVX512 };
+
+    kernel_isa detected = internal_detect();
+
+    tables[0] = KERNELS_SCALAR;
+    supported = kernel_isa::scalar;
+
+    for (size_t i = 1; i < ISA_COUNT; i++) {
+        kernel_table table = *built[i];
+        kernel_table below = tables[i - 1];
+
+        if (!table.md5_block) table.md5_block = below.md5_block;
+        if (!table.md5_lanes) table.md5_lanes = below.md5_lanes;
+        if (!table.rc4_xor)   table.rc4_xor   = below.rc4_xor;
+
+        tables[i] = table;
+
+        if ((kernel_isa)i <= detected && internal_built(*built[i]))
+            supported = (kernel_isa)i;
+    }
+
+    startup = supported;
+
+    if (const char* name = std::getenv("LIBCRYPT_KERNEL")) {
+        for (size_t i = 0; i <= (size_t)supported; i++) {
+            if (std::strcmp(name, kernels::to_string((kernel_isa)i)) == 0)
+                startup = (kernel_isa)i;
+        }
+    }
+
+    active.store(startup);
+}
+
+kernel_registry& internal_registry() {
+    static kernel_registry registry;
+    return registry;
+}
+
+kernel_isa internal_detect() {
+#if defined(LIBCRYPT_X86)
+    uint32_t regs[4]{};
+
+    auto cpuid = [&](uint32_t leaf, uint32_t subleaf) {
+    #if defined(_MSC_VER)
+        __cpuidex((int*)regs, (int)leaf, (int)subleaf);
+    #else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+    #endif
+    };
+
+    cpuid(0, 0);
+    uint32_t max_leaf = regs[0];
+
+    if (max_leaf < 1)
+        return kernel_isa::scalar;
+
+    cpuid(1, 0);
+    bool sse2    = regs[3] & (1U << 26);
+    bool osxsave = regs[2] & (1U << 27);
+
+    if (!sse2)
+        return kernel_isa::scalar;
+
+    if (!osxsave || max_leaf < 7)
+        return kernel_isa::sse2;
+
+    // Registers the OS saves on context switch
+    #if defined(_MSC_VER)
+    uint64_t xcr0 = _xgetbv(0);
+    #else
+    uint32_t xcr0_lo, xcr0_hi;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    uint64_t xcr0 = ((uint64_t)xcr0_hi << 32) | xcr0_lo;
+    #endif
+
+    cpuid(7, 0);
+    bool avx2     = regs[1] & (1U << 5);
+    bool bmi1     = regs[1] & (1U << 3);
+    bool bmi2     = regs[1] & (1U << 8);
+    bool avx512f  = regs[1] & (1U << 16);
+    bool avx512bw = regs[1] & (1U << 30);
+
+    if (!avx2 || !bmi1 || !bmi2 || (xcr0 & 0x06) != 0x06)
+        return kernel_isa::sse2;
+
+    if (!avx512f || !avx512bw || (xcr0 & 0xE6) != 0xE6)
+        return kernel_isa::avx2;
+
+    return kernel_isa::avx512;
+#else
+    return kernel_isa::scalar;
+#endif
+}
+
+bool internal_built(const kernel_table& table) {
+    return table.md5_block || table.md5_lanes || table.rc4_xor;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "misc/kernel_table.hpp"
+
+#if defined(__AVX2__)
+    #include "md5/md5_isa.hpp"
+    #include <immintrin.h>
+
+    #if defined(__GNUC__) || defined(__clang__)
+        #define LIBCRYPT_MD5_LANES 8
+        #include "md5/md5_lanes.hpp"
+    #endif
+#endif
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+#if defined(__AVX2__)
+static void internal_md5_block(uint32_t* hash, const uint32_t* words);
+static void internal_rc4_xor(const uint8_t* src, const uint8_t* keystream, uint8_t* dst, size_t size);
+#endif
+
+#if defined(LIBCRYPT_MD5_LANES)
+static void internal_md5_lanes(const std::span<const uint8_t>* messages, size_t count, std::array<uint8_t, 16>* digests);
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+const kernel_table libcrypt::KERNELS_AVX2 = {
+#if defined(__AVX2__)
+    internal_md5_block,
+#else
+    nullptr,
+#endif
+#if defined(LIBCRYPT_MD5_LANES)
+    internal_md5_lanes,
+#else
+    nullptr,
+#endif
+#if defined(__AVX2__)
+    internal_rc4_xor
+#else
+    nullptr
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+#if defined(__AVX2__)
+// Same rounds as scalar, built with BMI for andn and rorx
+void internal_md5_block(uint32_t* hash, const uint32_t* words) {
+    internal_md5_transform(hash, words);
+}
+
+void internal_rc4_xor(const uint8_t* src, const uint8_t* keystream, uint8_t* dst, size_t size) {
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i data = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i key  = _mm256_loadu_si256((const __m256i*)(keystream + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(data, key));
+    }
+
+    for (; i < size; i++)
+        dst[i] = src[i] ^ keystream[i];
+}
+#endif
+
+#if defined(LIBCRYPT_MD5_LANES)
+void internal_md5_lanes(const std::span<const uint8_t>* messages, size_t count, std::array<uint8_t, 16>* digests) {
+    internal_compute_lanes(messages, count, digests);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "misc/kernel_table.hpp"
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+    #define LIBCRYPT_KERNELS_AVX512
+    #include <immintrin.h>
+
+    #if defined(__GNUC__) || defined(__clang__)
+        #define LIBCRYPT_MD5_LANES 16
+        #include "md5/md5_lanes.hpp"
+    #endif
+#endif
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+#if defined(LIBCRYPT_KERNELS_AVX512)
+static void internal_rc4_xor(const uint8_t* src, const uint8_t* keystream, uint8_t* dst, size_t size);
+#endif
+
+#if defined(LIBCRYPT_MD5_LANES)
+static void internal_md5_lanes(const std::span<const uint8_t>* messages, size_t count, std::array<uint8_t, 16>* digests);
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+// md5 blocks use the avx2 kernel
+const kernel_table libcrypt::KERNELS_AVX512 = {
+    nullptr,
+#if defined(LIBCRYPT_MD5_LANES)
+    internal_md5_lanes,
+#else
+    nullptr,
+#endif
+#if defined(LIBCRYPT_KERNELS_AVX512)
+    internal_rc4_xor
+#else
+    nullptr
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+#if defined(LIBCRYPT_KERNELS_AVX512)
+// Tail is handled with a masked load and store
+void internal_rc4_xor(const uint8_t* src, const uint8_t* keystream, uint8_t* dst, size_t size) {
+    size_t i = 0;
+
+    for (; i + 64 <= size; i += 64) {
+        __m512i data = _mm512_loadu_si512((const void*)(src + i));
+        __m512i key  = _mm512_loadu_si512((const void*)(keystream + i));
+        _mm512_storeu_si512((void*)(dst + i), _mm512_xor_si512(data, key));
+    }
+
+    if (i < size) {
+        __mmask64 mask = ~0ULL >> (64 - (size - i));
+
+        __m512i data = _mm512_maskz_loadu_epi8(mask, src + i);
+        __m512i key  = _mm512_maskz_loadu_epi8(mask, keystream + i);
+        _mm512_mask_storeu_epi8(dst + i, mask, _mm512_xor_si512(data, key));
+    }
+}
+#endif
+
+#if defined(LIBCRYPT_MD5_LANES)
+void internal_md5_lanes(const std::span<const uint8_t>* messages, size_t count, std::array<uint8_t, 16>* digests) {
+    internal_compute_lanes(messages, count, digests);
+}
+#endif
\ No newline at end of file
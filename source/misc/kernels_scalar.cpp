@@ -0,0 +1,66 @@
+#include "misc/kernel_table.hpp"
+#include "libcrypt/md5/md5.hpp"
+#include "md5/md5_isa.hpp"
+
+#include <cstring>
+
+// Non x86 targets get generic vectors, typically NEON
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    !(defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+
+    #define LIBCRYPT_MD5_LANES 4
+    #include "md5/md5_lanes.hpp"
+#endif
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+static void internal_md5_block(uint32_t* hash, const uint32_t* words);
+static void internal_md5_lanes(const std::span<const uint8_t>* messages, size_t count, std::array<uint8_t, 16>* digests);
+static void internal_rc4_xor(const uint8_t* src, const uint8_t* keystream, uint8_t* dst, size_t size);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+const kernel_table libcrypt::KERNELS_SCALAR = {
+    internal_md5_block,
+    internal_md5_lanes,
+    internal_rc4_xor
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+void internal_md5_block(uint32_t* hash, const uint32_t* words) {
+    internal_md5_transform(hash, words);
+}
+
+void internal_md5_lanes(const std::span<const uint8_t>* messages, size_t count, std::array<uint8_t, 16>* digests) {
+#if defined(LIBCRYPT_MD5_LANES)
+    internal_compute_lanes(messages, count, digests);
+#else
+    md5 hasher;
+
+    for (size_t i = 0; i < count; i++)
+        digests[i] = hasher.compute(messages[i].data(), messages[i].size());
+#endif
+}
+
+void internal_rc4_xor(const uint8_t* src, const uint8_t* keystream, uint8_t* dst, size_t size) {
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        uint64_t data, key;
+
+        std::memcpy(&data, src + i, sizeof(data));
+        std::memcpy(&key, keystream + i, sizeof(key));
+
+        data ^= key;
+        std::memcpy(dst + i, &data, sizeof(data));
+    }
+
+    for (; i < size; i++)
+        dst[i] = src[i] ^ keystream[i];
+}
\ No newline at end of file
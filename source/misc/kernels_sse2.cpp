@@ -0,0 +1,66 @@
+#include "misc/kernel_table.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define LIBCRYPT_KERNELS_SSE2
+    #include <immintrin.h>
+
+    #if defined(__GNUC__) || defined(__clang__)
+        #define LIBCRYPT_MD5_LANES 4
+        #include "md5/md5_lanes.hpp"
+    #endif
+#endif
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+#if defined(LIBCRYPT_KERNELS_SSE2)
+static void internal_rc4_xor(const uint8_t* src, const uint8_t* keystream, uint8_t* dst, size_t size);
+#endif
+
+#if defined(LIBCRYPT_MD5_LANES)
+static void internal_md5_lanes(const std::span<const uint8_t>* messages, size_t count, std::array<uint8_t, 16>* digests);
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+// md5 block compression is serial, there is nothing to gain over scalar
+const kernel_table libcrypt::KERNELS_SSE2 = {
+    nullptr,
+#if defined(LIBCRYPT_MD5_LANES)
+    internal_md5_lanes,
+#else
+    nullptr,
+#endif
+#if defined(LIBCRYPT_KERNELS_SSE2)
+    internal_rc4_xor
+#else
+    nullptr
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+#if defined(LIBCRYPT_KERNELS_SSE2)
+void internal_rc4_xor(const uint8_t* src, const uint8_t* keystream, uint8_t* dst, size_t size) {
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i data = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i key  = _mm_loadu_si128((const __m128i*)(keystream + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(data, key));
+    }
+
+    for (; i < size; i++)
+        dst[i] = src[i] ^ keystream[i];
+}
+#endif
+
+#if defined(LIBCRYPT_MD5_LANES)
+void internal_md5_lanes(const std::span<const uint8_t>* messages, size_t count, std::array<uint8_t, 16>* digests) {
+    internal_compute_lanes(messages, count, digests);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "misc/mapped_file.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define LIBCRYPT_HAS_MMAP
+
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+mapped_file::mapped_file() {
+    m_fd   = -1;
+    m_data = nullptr;
+    m_size = 0U;
+}
+
+mapped_file::~mapped_file() {
+    close();
+}
+
+crypt_result mapped_file::open(const std::filesystem::path& path, bool writable) {
+    crypt_result result;
+
+    close();
+
+#if defined(LIBCRYPT_HAS_MMAP)
+    m_fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (m_fd == -1) {
+        result.message = "Failed to open input file.";
+        return result;
+    }
+
+    struct stat info{};
+    if (fstat(m_fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close();
+        result.message = "Failed to open input file.";
+        return result;
+    }
+
+    m_size = (size_t)info.st_size;
+
+    // Empty files can't be mapped but are valid
+    if (m_size != 0) {
+        void* data = mmap(nullptr, m_size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+            MAP_SHARED, m_fd, 0);
+
+        if (data == MAP_FAILED) {
+            close();
+            result.message = "Failed to map input file.";
+            return result;
+        }
+
+        m_data = (uint8_t*)data;
+        madvise(m_data, m_size, MADV_SEQUENTIAL);
+    }
+
+    result.success = true;
+#else
+    (void)path;
+    (void)writable;
+
+    result.message = "Memory mapping not supported.";
+#endif
+
+    return result;
+}
+
+void mapped_file::close() {
+#if defined(LIBCRYPT_HAS_MMAP)
+    if (m_data)
+        munmap(m_data, m_size);
+
+    if (m_fd != -1)
+        ::close(m_fd);
+#endif
+
+    m_fd   = -1;
+    m_data = nullptr;
+    m_size = 0U;
+}
+
+bool mapped_file::is_open() const {
+    return m_fd != -1;
+}
+
+uint8_t* mapped_file::data() const {
+    return m_data;
+}
+
+size_t mapped_file::size() const {
+    return m_size;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "libcrypt/misc/crypt_result.hpp"
+
+#include <filesystem>
+#include <cstdint>
+
+namespace libcrypt {
+    // Memory mapped view of a whole file.
+    // Mapping is only available on POSIX systems, open() fails elsewhere and
+    // callers are expected to fall back to stream IO.
+    class mapped_file {
+    public:
+        mapped_file();
+        mapped_file(const mapped_file&) = delete;
+        mapped_file(mapped_file&&)      = delete;
+
+        ~mapped_file();
+
+        mapped_file& operator=(const mapped_file&) = delete;
+        mapped_file& operator=(mapped_file&&)      = delete;
+
+    public:
+        // Map the file, writable mappings are shared with the file.
+        // Pages are advised for sequential access.
+        crypt_result open(const std::filesystem::path& path, bool writable);
+
+        // Unmap the file
+        void close();
+
+        bool is_open() const;
+
+        uint8_t* data() const;
+
+        size_t size() const;
+
+    private:
+        int      m_fd;
+        uint8_t* m_data;
+        size_t   m_size;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "libcrypt/misc/thread_pool.hpp"
+
+#include <algorithm>
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+// Pool and queue of the worker running on this thread
+static thread_local const thread_pool* worker_pool  = nullptr;
+static thread_local size_t             worker_index = 0U;
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+thread_pool::thread_pool(size_t thread_count) {
+    m_queued   = 0U;
+    m_pending  = 0U;
+    m_stopping = false;
+
+    if (thread_count == 0U)
+        thread_count = std::max(1U, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < thread_count; i++)
+        m_queues.push_back(std::make_unique<worker_queue>());
+
+    for (size_t i = 0; i < thread_count; i++)
+        m_threads.emplace_back(&thread_pool::run_worker, this, i);
+}
+
+thread_pool::~thread_pool() {
+    wait();
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+size_t thread_pool::get_thread_count() const {
+    return m_threads.size();
+}
+
+void thread_pool::submit(task_t task) {
+    // Counted before the task is visible so a finishing task can't drop
+    // pending to zero early
+    {
+        std::lock_guard lock(m_mutex);
+        m_queued++;
+        m_pending++;
+    }
+
+    auto& queue = worker_pool == this ? *m_queues[worker_index] : m_injected;
+
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    m_wake.notify_one();
+}
+
+void thread_pool::wait() {
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_pending == 0U; });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+void thread_pool::run_worker(size_t index) {
+    worker_pool  = this;
+    worker_index = index;
+
+    while (true) {
+        if (run_one(index))
+            continue;
+
+        std::unique_lock lock(m_mutex);
+        m_wake.wait(lock, [this]() { return m_stopping || m_queued > 0U; });
+
+        if (m_stopping && m_queued == 0U)
+            return;
+    }
+}
+
+bool thread_pool::run_one(size_t index) {
+    task_t task;
+    size_t count = m_queues.size();
+
+    // Own queue is used as a stack for tasks this worker spawned
+    {
+        auto& queue = *m_queues[index];
+        std::lock_guard lock(queue.mutex);
+
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+    }
+
+    // External tasks start in the order they were submitted
+    if (!task) {
+        std::lock_guard lock(m_injected.mutex);
+
+        if (!m_injected.tasks.empty()) {
+            task = std::move(m_injected.tasks.front());
+            m_injected.tasks.pop_front();
+        }
+    }
+
+    // Stolen tasks are the oldest
+    for (size_t i = 1; i < count && !task; i++) {
+        auto& queue = *m_queues[(index + i) % count];
+        std::lock_guard lock(queue.mutex);
+
+        if (queue.tasks.empty())
+            continue;
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+    }
+
+    if (!task)
+        return false;
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_queued--;
+    }
+
+    task();
+
+    bool idle;
+    {
+        std::lock_guard lock(m_mutex);
+        idle = --m_pending == 0U;
+    }
+
+    if (idle)
+        m_idle.notify_all();
+
+    return true;
+}
\ No newline at end of file
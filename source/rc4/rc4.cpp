@@ -1,18 +1,21 @@
 #include "libcrypt/rc4/rc4.hpp"
+#include "libcrypt/md5/md5.hpp"
+#include "rc4/rc4_internal.hpp"
+#include "misc/mapped_file.hpp"
 
 #include <fstream>
-#include <sstream>
+#include <future>
+#include <cstring>
 
 using namespace libcrypt;
 
 ///////////////////////////////////////////////////////////////////////////////
 // INTERNAL
 
-static std::string internal_parse_key(const char* key, size_t size);
-static std::string internal_hex_string_to_string(const std::string& hex_string);
+// Fused crypt and hash tile, data and keystream stay in L1
+static const size_t FUSED_TILE_SIZE = 4096;
 
-static void internal_swap(uint8_t* buffer, uint32_t i, uint32_t j);
-static crypt_result internal_write(std::filesystem::path& output, const rc4::buffer_t& buffer);
+static void internal_create_directories(const std::filesystem::path& output);
 
 ///////////////////////////////////////////////////////////////////////////////
 // PUBLIC
@@ -20,8 +23,13 @@ static crypt_result internal_write(std::filesystem::path& output, const rc4::buf
 rc4::rc4() {
     reset();
 
-    m_key = "";
-    m_iv  = 0U;
+    m_key               = "";
+    m_iv                = 0U;
+    m_initial_box_valid = false;
+    m_checkpoints       = nullptr;
+    m_chunk_size        = DEFAULT_CHUNK_SIZE;
+    m_cursor_count      = DEFAULT_CURSOR_COUNT;
+    m_cursor_clock      = 0U;
 }
 
 void rc4::reset() {
@@ -31,7 +39,8 @@ void rc4::reset() {
 void rc4::set_key(const char* key, size_t size) {
     if (!key) return;
 
-    m_key = internal_parse_key(key, size);
+    m_key               = internal_parse_key(key, size);
+    m_initial_box_valid = false;
 }
 
 void rc4::set_key(const std::string& key) {
@@ -39,7 +48,12 @@ void rc4::set_key(const std::string& key) {
 }
 
 void rc4::set_iv(uint8_t iv) {
-    m_iv = iv;
+    m_iv                = iv;
+    m_initial_box_valid = false;
+}
+
+void rc4::set_key_schedule(const rc4_key_schedule& schedule) {
+    set_key_schedule(schedule.get_key(), schedule.get_iv(), schedule.get_box());
 }
 
 const std::string& rc4::get_key() const {
@@ -50,65 +64,310 @@ uint8_t rc4::get_iv() const {
     return m_iv;
 }
 
-crypt_result rc4::encrypt_file(const file_path_t& input, const file_path_t& output) {
-    buffer_t buffer;
-    
-    auto result = encrypt_file(input, buffer);
-    if (!result)
-        return result;
+void rc4::set_chunk_size(size_t size) {
+    m_chunk_size = size != 0 ? size : DEFAULT_CHUNK_SIZE;
+}
 
-    file_path_t output_path = output == "" ? input : output;
-    return internal_write(output_path, buffer);
+size_t rc4::get_chunk_size() const {
+    return m_chunk_size;
 }
 
-crypt_result rc4::encrypt_file(const file_path_t& input, buffer_t& out) {
+crypt_result rc4::build_checkpoints(rc4_checkpoints& checkpoints, size_t length, size_t interval) const {
     crypt_result result;
 
-    if (!std::filesystem::exists(input)) {
-        result.message = "Input file not found.";
-        return result;
-    }
+    checkpoints.clear();
 
-    std::ifstream fin(input, std::ios::binary | std::ios::in | std::ios::ate);
-    if (!fin.is_open()) {
-        result.message = "Failed to open input file.";
+    if (interval == 0) {
+        result.message = "Checkpoint interval must be greater than 0.";
         return result;
     }
 
-    size_t size = (size_t)fin.tellg();
-    out.resize(size);
-    fin.seekg(0, std::ios::beg);
+    rc4_checkpoints::checkpoint current{};
+    internal_generate_box(current.box, m_key, m_iv);
 
-    if (!fin.read((char*)out.data(), size)) {
-        result.message = "Failed to read input file.";
-        return result;
+    uint32_t index_A = 0;
+    uint32_t index_B = 0;
+
+    checkpoints.m_interval = interval;
+    checkpoints.m_checkpoints.reserve(length / interval + 1);
+
+    for (size_t offset = 0; ; offset += interval) {
+        current.index_A = (uint8_t)index_A;
+        current.index_B = (uint8_t)index_B;
+        checkpoints.m_checkpoints.push_back(current);
+
+        if (length - offset < interval)
+            break;
+
+        internal_skip(current.box, index_A, index_B, interval);
     }
 
-    fin.close();
+    result.success = true;
+    return result;
+}
+
+void rc4::set_checkpoints(const rc4_checkpoints* checkpoints) {
+    m_checkpoints = checkpoints;
+    reset();
+}
+
+void rc4::set_cursor_count(size_t count) {
+    m_cursor_count = count != 0 ? count : 1;
+    m_cursors.clear();
+}
+
+size_t rc4::get_cursor_count() const {
+    return m_cursor_count;
+}
+
+crypt_result rc4::encrypt_file(const file_path_t& input, const file_path_t& output) {
+    return crypt_file(input, output);
+}
+
+crypt_result rc4::encrypt_file(const file_path_t& input, buffer_t& out) {
+    return crypt_file(input, out);
+}
 
-    return encrypt_buffer(out);
+task<crypt_result> rc4::encrypt_file_async(executor& exec, const file_path_t& input, const file_path_t& output) {
+    return crypt_file_async(exec, input, output);
 }
 
 crypt_result rc4::encrypt_buffer(buffer_t& buffer) {
     return crypt(buffer);
 }
 
+crypt_result rc4::encrypt_buffer(const buffer_t& input, buffer_t& out) {
+    out.resize(input.size());
+    return crypt(input.data(), out.data(), input.size(), 0, false);
+}
+
+crypt_result rc4::encrypt_buffer(const uint8_t* src, uint8_t* dst, size_t size) {
+    return crypt(src, dst, size, 0, false);
+}
+
+crypt_result rc4::encrypt_buffer(std::span<const segment_t> segments) {
+    return crypt(segments, 0, false);
+}
+
+crypt_result rc4::encrypt_buffer(buffer_t& buffer, hash_t& hash, hashed_data hashed) {
+    return crypt(buffer, hash, hashed == hashed_data::plaintext);
+}
+
 crypt_result rc4::encrypt_stream(uint8_t* ptr, size_t size, size_t offset) {
     return crypt(ptr, size, offset, true);
 }
 
-crypt_result rc4::decrypt_file(const file_path_t& input, const file_path_t& output) {
-    buffer_t buffer;
+crypt_result rc4::encrypt_stream(const uint8_t* src, uint8_t* dst, size_t size, size_t offset) {
+    return crypt(src, dst, size, offset, true);
+}
 
-    auto result = decrypt_file(input, buffer);
-    if (!result)
-        return result;
+crypt_result rc4::encrypt_stream(std::span<const segment_t> segments, size_t offset) {
+    return crypt(segments, offset, true);
+}
 
-    file_path_t output_path = output == "" ? input : output;
-    return internal_write(output_path, buffer);
+crypt_result rc4::decrypt_file(const file_path_t& input, const file_path_t& output) {
+    return crypt_file(input, output);
 }
 
 crypt_result rc4::decrypt_file(const file_path_t& input, buffer_t& out) {
+    return crypt_file(input, out);
+}
+
+task<crypt_result> rc4::decrypt_file_async(executor& exec, const file_path_t& input, const file_path_t& output) {
+    return crypt_file_async(exec, input, output);
+}
+
+crypt_result rc4::decrypt_buffer(buffer_t& buffer) {
+    return crypt(buffer);
+}
+
+crypt_result rc4::decrypt_buffer(const buffer_t& input, buffer_t& out) {
+    out.resize(input.size());
+    return crypt(input.data(), out.data(), input.size(), 0, false);
+}
+
+crypt_result rc4::decrypt_buffer(const uint8_t* src, uint8_t* dst, size_t size) {
+    return crypt(src, dst, size, 0, false);
+}
+
+crypt_result rc4::decrypt_buffer(std::span<const segment_t> segments) {
+    return crypt(segments, 0, false);
+}
+
+crypt_result rc4::decrypt_buffer(buffer_t& buffer, const hash_t& expected, hashed_data hashed) {
+    hash_t       hash;
+    crypt_result result = crypt(buffer, hash, hashed == hashed_data::ciphertext);
+
+    if (result && hash != expected) {
+        result.success = false;
+        result.message = "Hash mismatch.";
+    }
+
+    return result;
+}
+
+crypt_result rc4::decrypt_stream(uint8_t* ptr, size_t size, size_t offset) {
+    return crypt(ptr, size, offset, true);
+}
+
+crypt_result rc4::decrypt_stream(const uint8_t* src, uint8_t* dst, size_t size, size_t offset) {
+    return crypt(src, dst, size, offset, true);
+}
+
+crypt_result rc4::decrypt_stream(std::span<const segment_t> segments, size_t offset) {
+    return crypt(segments, offset, true);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PROTECTED
+
+void rc4::set_key_schedule(const std::string& key, uint8_t iv, const uint8_t* box) {
+    m_key = key;
+    m_iv  = iv;
+
+    std::memcpy(m_initial_box, box, sizeof(m_initial_box));
+    m_initial_box_valid = true;
+
+    // Stream state and parked cursors belong to the old key
+    m_cursors.clear();
+    reset();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+void rc4::generate_box() {
+    m_index_A         = 0;
+    m_index_B         = 0;
+    m_previous_offset = 0;
+
+    m_cursors.clear();
+
+    if (!m_initial_box_valid) {
+        internal_generate_box(m_initial_box, m_key, m_iv);
+        m_initial_box_valid = true;
+    }
+
+    std::memcpy(m_box, m_initial_box, sizeof(m_box));
+
+    m_initialized = true;
+}
+
+const rc4_checkpoints::checkpoint* rc4::find_checkpoint(uint64_t offset, uint64_t& checkpoint_offset) const {
+    checkpoint_offset = 0U;
+
+    if (!m_checkpoints)
+        return nullptr;
+
+    // First checkpoint is the initial box, if it doesn't match
+    // the checkpoints were built for a different key or iv
+    const auto* first = m_checkpoints->find(0U, checkpoint_offset);
+    if (!first || std::memcmp(first->box, m_initial_box, sizeof(m_initial_box)) != 0)
+        return nullptr;
+
+    return m_checkpoints->find(offset, checkpoint_offset);
+}
+
+void rc4::seek(uint64_t offset) {
+    enum class source { current, cursor, checkpoint, initial };
+
+    // Key or iv changed mid stream
+    if (!m_initial_box_valid)
+        generate_box();
+
+    source   from     = m_previous_offset <= offset ? source::current : source::initial;
+    uint64_t position = from == source::current ? m_previous_offset : 0U;
+
+    uint64_t    checkpoint_offset = 0U;
+    const auto* checkpoint        = find_checkpoint(offset, checkpoint_offset);
+
+    if (checkpoint && checkpoint_offset > position) {
+        from     = source::checkpoint;
+        position = checkpoint_offset;
+    }
+
+    stream_cursor* nearest = nullptr;
+    for (auto& cursor : m_cursors) {
+        if (cursor.offset <= offset && (!nearest || cursor.offset > nearest->offset))
+            nearest = &cursor;
+    }
+
+    if (nearest && (nearest->offset > position || (nearest->offset == position && from != source::current))) {
+        from     = source::cursor;
+        position = nearest->offset;
+    }
+
+    switch (from) {
+        case source::current:
+            // Old position is kept for a reader going back to it
+            park_cursor();
+            break;
+
+        case source::cursor: {
+            // Current state takes the place of the restored cursor
+            stream_cursor current;
+            std::memcpy(current.box, m_box, sizeof(m_box));
+            current.index_A   = m_index_A;
+            current.index_B   = m_index_B;
+            current.offset    = m_previous_offset;
+            current.last_used = ++m_cursor_clock;
+
+            std::memcpy(m_box, nearest->box, sizeof(m_box));
+            m_index_A = nearest->index_A;
+            m_index_B = nearest->index_B;
+
+            *nearest = current;
+            break;
+        }
+
+        case source::checkpoint:
+            park_cursor();
+
+            std::memcpy(m_box, checkpoint->box, sizeof(m_box));
+            m_index_A = checkpoint->index_A;
+            m_index_B = checkpoint->index_B;
+            break;
+
+        case source::initial:
+            park_cursor();
+
+            std::memcpy(m_box, m_initial_box, sizeof(m_box));
+            m_index_A = 0;
+            m_index_B = 0;
+            break;
+    }
+
+    internal_skip(m_box, m_index_A, m_index_B, offset - position);
+    m_previous_offset = offset;
+}
+
+void rc4::park_cursor() {
+    if (m_cursor_count <= 1)
+        return;
+
+    stream_cursor* slot = nullptr;
+
+    for (auto& cursor : m_cursors) {
+        if (cursor.offset == m_previous_offset) {
+            cursor.last_used = ++m_cursor_clock;
+            return;
+        }
+
+        if (!slot || cursor.last_used < slot->last_used)
+            slot = &cursor;
+    }
+
+    if (m_cursors.size() < m_cursor_count - 1)
+        slot = &m_cursors.emplace_back();
+
+    std::memcpy(slot->box, m_box, sizeof(m_box));
+    slot->index_A   = m_index_A;
+    slot->index_B   = m_index_B;
+    slot->offset    = m_previous_offset;
+    slot->last_used = ++m_cursor_clock;
+}
+
+crypt_result rc4::crypt_file(const file_path_t& input, buffer_t& out) {
     crypt_result result;
 
     if (!std::filesystem::exists(input)) {
@@ -116,6 +375,13 @@ crypt_result rc4::decrypt_file(const file_path_t& input, buffer_t& out) {
         return result;
     }
 
+    // Crypt straight from the mapped pages into out
+    mapped_file mapping;
+    if (mapping.open(input, false)) {
+        out.resize(mapping.size());
+        return crypt(mapping.data(), out.data(), out.size(), 0, false);
+    }
+
     std::ifstream fin(input, std::ios::binary | std::ios::in | std::ios::ate);
     if (!fin.is_open()) {
         result.message = "Failed to open input file.";
@@ -133,131 +399,298 @@ crypt_result rc4::decrypt_file(const file_path_t& input, buffer_t& out) {
 
     fin.close();
 
-    return decrypt_buffer(out);
+    return crypt(out);
 }
 
-crypt_result rc4::decrypt_buffer(buffer_t& buffer) {
-    return crypt(buffer);
-}
+crypt_result rc4::crypt_file(const file_path_t& input, const file_path_t& output) {
+    crypt_result result;
 
-crypt_result rc4::decrypt_stream(uint8_t* ptr, size_t size, size_t offset) {
-    return crypt(ptr, size, offset, true);
+    if (!std::filesystem::exists(input)) {
+        result.message = "Input file not found.";
+        return result;
+    }
+
+    bool in_place = output == "" ||
+        (std::filesystem::exists(output) && std::filesystem::equivalent(input, output));
+
+    // In place crypt runs directly on the mapped pages
+    if (in_place) {
+        mapped_file mapping;
+        if (mapping.open(input, true))
+            return crypt(mapping.data(), mapping.data(), mapping.size(), 0, false);
+    }
+
+    std::ifstream fin(input, std::ios::binary | std::ios::in | std::ios::ate);
+    if (!fin.is_open()) {
+        result.message = "Failed to open input file.";
+        return result;
+    }
+
+    uint64_t remaining = (uint64_t)fin.tellg();
+    fin.seekg(0, std::ios::beg);
+
+    file_path_t output_path = in_place ? input : output;
+    internal_create_directories(output_path);
+
+    // In place output must not be truncated, chunks are written behind the reads
+    std::fstream fout(output_path, in_place ?
+        std::ios::binary | std::ios::in  | std::ios::out :
+        std::ios::binary | std::ios::out | std::ios::trunc);
+
+    if (!fout.is_open()) {
+        result.message = "Failed to open output file.";
+        return result;
+    }
+
+    // Triple buffering, the next chunk is read and the previous one written
+    // while the current one is crypted
+    buffer_t buffers[3];
+    for (auto& buffer : buffers)
+        buffer.resize((size_t)std::min<uint64_t>(m_chunk_size, remaining));
+
+    bool read_failed = false;
+
+    auto read_chunk = [&](buffer_t& buffer) -> size_t {
+        size_t size = (size_t)std::min<uint64_t>(buffer.size(), remaining);
+        remaining  -= size;
+
+        if (size != 0 && !fin.read((char*)buffer.data(), size)) {
+            read_failed = true;
+            return 0;
+        }
+
+        return size;
+    };
+
+    auto write_chunk = [&](const buffer_t& buffer, size_t size) -> bool {
+        return (bool)fout.write((const char*)buffer.data(), size);
+    };
+
+    std::future<size_t> pending_read = std::async(std::launch::async, read_chunk, std::ref(buffers[0]));
+    std::future<bool>   pending_write;
+
+    uint64_t offset  = 0U;
+    bool     success = true;
+
+    reset();
+
+    for (size_t i = 0; pending_read.valid(); i++) {
+        buffer_t& current = buffers[i % 3];
+        size_t    size    = pending_read.get();
+
+        if (size == 0) {
+            success = !read_failed;
+            break;
+        }
+
+        if (remaining != 0)
+            pending_read = std::async(std::launch::async, read_chunk, std::ref(buffers[(i + 1) % 3]));
+
+        crypt(current.data(), size, offset, true);
+        offset += size;
+
+        if (pending_write.valid() && !pending_write.get()) {
+            success = false;
+            break;
+        }
+
+        pending_write = std::async(std::launch::async, write_chunk, std::cref(current), size);
+    }
+
+    reset();
+
+    if (pending_read.valid())
+        pending_read.wait();
+
+    if (pending_write.valid() && !pending_write.get())
+        success = false;
+
+    if (!success) {
+        result.message = read_failed ? "Failed to read input file." : "Failed to write output file.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// PRIVATE
+// Paths are copied into the coroutine frame
+task<crypt_result> rc4::crypt_file_async(executor& exec, file_path_t input, file_path_t output) {
+    crypt_result result;
 
-void rc4::generate_box() {
-    m_index_A         = 0;
-    m_index_B         = 0;
-    m_previous_offset = 0;
+    if (!std::filesystem::exists(input)) {
+        result.message = "Input file not found.";
+        co_return result;
+    }
 
-    for (uint32_t i = 0; i < 256; i++) {
-        m_box[i] = (uint8_t)(m_iv ^ 0xFF);
+    bool in_place = output == "" ||
+        (std::filesystem::exists(output) && std::filesystem::equivalent(input, output));
 
-        m_iv = m_iv == 0xFF ? 0x00 : m_iv + 1;
+    std::ios::openmode mode = std::ios::binary | std::ios::in | std::ios::ate;
+    if (in_place)
+        mode |= std::ios::out;
+
+    std::fstream fin(input, mode);
+    if (!fin.is_open()) {
+        result.message = "Failed to open input file.";
+        co_return result;
     }
 
-    uint8_t mod = m_key.size() <= 0xFF ? (uint8_t)m_key.size() : 0xFF;
+    uint64_t size = (uint64_t)fin.tellg();
 
-    uint32_t j = 0;
-    for (uint32_t i = 0; i < 256; i++) {
-        j += m_box[i];
-        j += m_key[i % mod];
-        j %= 256;
+    std::ofstream fout;
+    if (!in_place) {
+        internal_create_directories(output);
 
-        internal_swap(m_box, i, j);
+        fout.open(output, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!fout.is_open()) {
+            result.message = "Failed to open output file.";
+            co_return result;
+        }
     }
 
-    m_initialized = true;
+    buffer_t chunk((size_t)std::min<uint64_t>(m_chunk_size, size));
+
+    reset();
+
+    for (uint64_t offset = 0U; offset < size;) {
+        size_t count = (size_t)std::min<uint64_t>(chunk.size(), size - offset);
+
+        if (!fin.seekg((std::streamoff)offset) || !fin.read((char*)chunk.data(), count)) {
+            reset();
+            result.message = "Failed to read input file.";
+            co_return result;
+        }
+
+        crypt(chunk.data(), count, offset, true);
+
+        bool written = in_place ?
+            (bool)fin.seekp((std::streamoff)offset).write((const char*)chunk.data(), count) :
+            (bool)fout.write((const char*)chunk.data(), count);
+
+        if (!written) {
+            reset();
+            result.message = "Failed to write output file.";
+            co_return result;
+        }
+
+        offset += count;
+
+        co_await yield_to(exec);
+    }
+
+    reset();
+
+    result.success = true;
+    co_return result;
 }
 
 crypt_result rc4::crypt(rc4::buffer_t& buffer) {
     return crypt(buffer.data(), buffer.size(), false);
 }
 
-crypt_result rc4::crypt(uint8_t* ptr, size_t size, size_t offset, bool keep_box) {
+crypt_result rc4::crypt(rc4::buffer_t& buffer, hash_t& hash, bool hash_before) {
     crypt_result result;
+    md5          md5;
 
     if (!m_initialized)
         generate_box();
 
-    if (keep_box && offset != m_previous_offset) {
-        generate_box();
+    for (size_t offset = 0; offset < buffer.size(); offset += FUSED_TILE_SIZE) {
+        uint8_t* tile = buffer.data() + offset;
+        size_t   size = std::min(FUSED_TILE_SIZE, buffer.size() - offset);
 
-        for (uint64_t i = 0; i < offset; i++) {
-            m_index_A = (m_index_A + 1) % 256;
-            m_index_B = (m_index_B + m_box[m_index_A]) % 256;
-            internal_swap(m_box, m_index_A, m_index_B);
-        }
-    }
+        if (hash_before)
+            md5.update(tile, size);
 
-    for (uint64_t i = 0; i < size; i++) {
-        m_index_A = (m_index_A + 1) % 256;
-        m_index_B = (m_index_B + m_box[m_index_A]) % 256;
-        internal_swap(m_box, m_index_A, m_index_B);
-        ptr[i] = m_box[(m_box[m_index_A] + m_box[m_index_B]) % 256] ^ ptr[i];
+        internal_crypt(m_box, m_index_A, m_index_B, tile, tile, size);
+
+        if (!hash_before)
+            md5.update(tile, size);
     }
 
-    if (!keep_box)
-        m_initialized = false;
-    else
-        m_previous_offset += size;
+    m_initialized = false;
+
+    hash = md5.finalize();
 
     result.success = true;
     return result;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// INTERNAL
-
-std::string internal_parse_key(const char* key, size_t size) {
-    if (size >= 2 && key[0] == '0' && (key[1] == 'x' || key[1] == 'X'))
-        return internal_hex_string_to_string(std::string(key, key + size));
-
-    return std::string(key, key + size);
+crypt_result rc4::crypt(uint8_t* ptr, size_t size, size_t offset, bool keep_box) {
+    return crypt(ptr, ptr, size, offset, keep_box);
 }
 
-std::string internal_hex_string_to_string(const std::string& hex_string) {
-    std::string hex_data = hex_string.substr(2);
+crypt_result rc4::crypt(const uint8_t* src, uint8_t* dst, size_t size, size_t offset, bool keep_box) {
+    crypt_result result;
 
-    if (hex_data.length() % 2 != 0)
-        hex_data = '0' + hex_data;
+    if (!m_initialized)
+        generate_box();
 
-    std::stringstream ss;
-    for (size_t i = 0; i < hex_data.length(); i += 2)
-        ss << static_cast<char>(std::stoi(hex_data.substr(i, 2), nullptr, 16));
+    if (keep_box && offset != m_previous_offset)
+        seek(offset);
 
-    return ss.str();
-}
+    internal_crypt(m_box, m_index_A, m_index_B, src, dst, size);
 
-void internal_swap(uint8_t* buffer, uint32_t i, uint32_t j) {
-    uint8_t temp = buffer[i];
-    buffer[i]    = buffer[j];
-    buffer[j]    = temp;
+    if (!keep_box)
+        m_initialized = false;
+    else
+        m_previous_offset += size;
+
+    result.success = true;
+    return result;
 }
 
-crypt_result internal_write(std::filesystem::path& output, const rc4::buffer_t& buffer) {
+crypt_result rc4::crypt(std::span<const segment_t> segments, size_t offset, bool keep_box) {
     crypt_result result;
 
-    std::filesystem::path dir_path(output);
-    dir_path.remove_filename();
+    if (!m_initialized)
+        generate_box();
 
-    if (!std::filesystem::is_directory(dir_path)) {
-        std::filesystem::create_directories(dir_path);
-        std::filesystem::permissions(dir_path, std::filesystem::perms::all);
+    if (keep_box && offset != m_previous_offset)
+        seek(offset);
+
+    size_t size = 0U;
+    for (const auto& segment : segments)
+        size += segment.size();
+
+    // State carries over from one segment to the next, the box is widened
+    // once for all segments instead of once per segment
+    if (size < KEYSTREAM_MIN_SIZE) {
+        for (const auto& segment : segments)
+            internal_crypt(m_box, m_index_A, m_index_B, segment.data(), segment.data(), segment.size());
     }
+    else {
+        uint32_t wide_box[256];
 
-    std::ofstream out(output, std::ios::binary | std::ios::out);
+        for (int i = 0; i < 256; i++)
+            wide_box[i] = m_box[i];
 
-    if (!out.is_open()) {
-        result.message = "Failed to open output file.";
-        return result;
+        for (const auto& segment : segments)
+            internal_crypt_wide(wide_box, m_index_A, m_index_B, segment.data(), segment.data(), segment.size());
+
+        for (int i = 0; i < 256; i++)
+            m_box[i] = (uint8_t)wide_box[i];
     }
 
-    out.write((char*)buffer.data(), buffer.size());
-    out.close();
+    if (!keep_box)
+        m_initialized = false;
+    else
+        m_previous_offset += size;
 
     result.success = true;
     return result;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+void internal_create_directories(const std::filesystem::path& output) {
+    std::filesystem::path dir_path(output);
+    dir_path.remove_filename();
+
+    if (!dir_path.empty() && !std::filesystem::is_directory(dir_path)) {
+        std::filesystem::create_directories(dir_path);
+        std::filesystem::permissions(dir_path, std::filesystem::perms::all);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "libcrypt/rc4/rc4_batch.hpp"
+#include "rc4/rc4_internal.hpp"
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+static const size_t BATCH_LANES = 4;
+
+struct rc4_lane {
+    uint32_t    box[256];
+    uint32_t    index_A   = 0U;
+    uint32_t    index_B   = 0U;
+    uint8_t*    ptr       = nullptr;
+    size_t      remaining = 0U;
+    std::string key       = "";
+};
+
+static void internal_schedule_lanes(rc4_lane* lanes, const rc4_batch::record** records, size_t count);
+static void internal_crypt_lanes(rc4_lane* lanes, size_t size);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+crypt_result rc4_batch::crypt(std::span<record> records) {
+    crypt_result result;
+
+    rc4_lane lanes[BATCH_LANES];
+    bool     active[BATCH_LANES]{};
+    size_t   next = 0U;
+
+    while (true) {
+        // Refill finished lanes, their keys are scheduled together
+        const record* refill[BATCH_LANES]{};
+        rc4_lane      refill_lanes[BATCH_LANES];
+        size_t        refill_index[BATCH_LANES]{};
+        size_t        refill_count = 0U;
+
+        for (size_t lane = 0; lane < BATCH_LANES; lane++) {
+            if (active[lane])
+                continue;
+
+            while (next < records.size() && records[next].size == 0)
+                next++;
+
+            if (next == records.size())
+                break;
+
+            refill[refill_count]         = &records[next++];
+            refill_index[refill_count++] = lane;
+            active[lane]                 = true;
+        }
+
+        if (refill_count != 0) {
+            internal_schedule_lanes(refill_lanes, refill, refill_count);
+
+            for (size_t i = 0; i < refill_count; i++)
+                lanes[refill_index[i]] = std::move(refill_lanes[i]);
+        }
+
+        size_t active_count = 0U;
+        size_t size         = SIZE_MAX;
+
+        for (size_t lane = 0; lane < BATCH_LANES; lane++) {
+            if (!active[lane])
+                continue;
+
+            active_count++;
+            size = std::min(size, lanes[lane].remaining);
+        }
+
+        if (active_count == 0)
+            break;
+
+        // Once records run out, the last lanes are finished one at a time
+        if (active_count != BATCH_LANES) {
+            for (size_t lane = 0; lane < BATCH_LANES; lane++) {
+                if (!active[lane])
+                    continue;
+
+                uint8_t box[256];
+                for (int i = 0; i < 256; i++)
+                    box[i] = (uint8_t)lanes[lane].box[i];
+
+                internal_crypt(box, lanes[lane].index_A, lanes[lane].index_B,
+                    lanes[lane].ptr, lanes[lane].ptr, lanes[lane].remaining);
+
+                active[lane] = false;
+            }
+
+            continue;
+        }
+
+        internal_crypt_lanes(lanes, size);
+
+        for (size_t lane = 0; lane < BATCH_LANES; lane++) {
+            lanes[lane].ptr       += size;
+            lanes[lane].remaining -= size;
+            active[lane]           = lanes[lane].remaining != 0;
+        }
+    }
+
+    result.success = true;
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+void internal_schedule_lanes(rc4_lane* lanes, const rc4_batch::record** records, size_t count) {
+    const uint8_t* keys[BATCH_LANES]{};
+    uint32_t       mods[BATCH_LANES]{};
+    uint32_t       k[BATCH_LANES]{};
+    uint32_t       j[BATCH_LANES]{};
+    bool           scheduled[BATCH_LANES]{};
+    bool           all_scheduled = true;
+    const uint8_t  zero_key      = 0U;
+
+    for (size_t lane = 0; lane < count; lane++) {
+        const auto* record = records[lane];
+
+        lanes[lane].index_A   = 0U;
+        lanes[lane].index_B   = 0U;
+        lanes[lane].ptr       = record->ptr;
+        lanes[lane].remaining = record->size;
+
+        if (record->schedule) {
+            const uint8_t* box = record->schedule->get_box();
+            for (int i = 0; i < 256; i++)
+                lanes[lane].box[i] = box[i];
+
+            scheduled[lane] = true;
+            continue;
+        }
+
+        lanes[lane].key = internal_parse_key(record->key.data(), record->key.size());
+
+        uint8_t iv = record->iv;
+        for (int i = 0; i < 256; i++) {
+            lanes[lane].box[i] = (uint8_t)(iv ^ 0xFF);
+
+            iv = iv == 0xFF ? 0x00 : iv + 1;
+        }
+
+        keys[lane] = (const uint8_t*)lanes[lane].key.data();
+        mods[lane] = lanes[lane].key.size() <= 0xFF ? (uint32_t)lanes[lane].key.size() : 0xFF;
+
+        // Empty keys add 0 every step, same as a single zero byte
+        if (mods[lane] == 0) {
+            keys[lane] = &zero_key;
+            mods[lane] = 1;
+        }
+
+        all_scheduled = false;
+    }
+
+    if (all_scheduled)
+        return;
+
+    // Lanes without a key run a dummy schedule on a stack box so the
+    // lanes can be interleaved without branches
+    uint32_t dummy_box[BATCH_LANES][256]{};
+
+    uint32_t* boxes[BATCH_LANES];
+
+    for (size_t lane = 0; lane < BATCH_LANES; lane++) {
+        bool dummy = lane >= count || scheduled[lane];
+
+        boxes[lane] = dummy ? dummy_box[lane] : lanes[lane].box;
+
+        if (dummy) {
+            keys[lane] = &zero_key;
+            mods[lane] = 1;
+        }
+    }
+
+    // Key schedules of all lanes are interleaved.
+    // Key index wraps with a counter instead of i % mod.
+#define LIBCRYPT_RC4_LANE_KSA(lane) {                               \
+        uint32_t* box = boxes[lane];                                \
+        j[lane] = (j[lane] + box[i] + keys[lane][k[lane]]) & 0xFF;  \
+        k[lane] = k[lane] + 1 == mods[lane] ? 0 : k[lane] + 1;      \
+        uint32_t temp = box[i];                                     \
+        box[i]        = box[j[lane]];                               \
+        box[j[lane]]  = temp;                                       \
+    }
+
+    for (uint32_t i = 0; i < 256; i++) {
+        LIBCRYPT_RC4_LANE_KSA(0);
+        LIBCRYPT_RC4_LANE_KSA(1);
+        LIBCRYPT_RC4_LANE_KSA(2);
+        LIBCRYPT_RC4_LANE_KSA(3);
+    }
+
+#undef LIBCRYPT_RC4_LANE_KSA
+}
+
+void internal_crypt_lanes(rc4_lane* lanes, size_t size) {
+    uint32_t* box0 = lanes[0].box;
+    uint32_t* box1 = lanes[1].box;
+    uint32_t* box2 = lanes[2].box;
+    uint32_t* box3 = lanes[3].box;
+
+    uint8_t* ptr0 = lanes[0].ptr;
+    uint8_t* ptr1 = lanes[1].ptr;
+    uint8_t* ptr2 = lanes[2].ptr;
+    uint8_t* ptr3 = lanes[3].ptr;
+
+    uint32_t a0 = lanes[0].index_A, b0 = lanes[0].index_B;
+    uint32_t a1 = lanes[1].index_A, b1 = lanes[1].index_B;
+    uint32_t a2 = lanes[2].index_A, b2 = lanes[2].index_B;
+    uint32_t a3 = lanes[3].index_A, b3 = lanes[3].index_B;
+
+#define LIBCRYPT_RC4_LANE_STEP(box, a, b, ptr) {   \
+        a = (a + 1) & 0xFF;                         \
+        uint32_t x = box[a];                        \
+        b = (b + x) & 0xFF;                         \
+        uint32_t y = box[b];                        \
+        box[a] = y;                                 \
+        box[b] = x;                                 \
+        ptr[i] ^= (uint8_t)box[(x + y) & 0xFF];     \
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        LIBCRYPT_RC4_LANE_STEP(box0, a0, b0, ptr0);
+        LIBCRYPT_RC4_LANE_STEP(box1, a1, b1, ptr1);
+        LIBCRYPT_RC4_LANE_STEP(box2, a2, b2, ptr2);
+        LIBCRYPT_RC4_LANE_STEP(box3, a3, b3, ptr3);
+    }
+
+#undef LIBCRYPT_RC4_LANE_STEP
+
+    lanes[0].index_A = a0; lanes[0].index_B = b0;
+    lanes[1].index_A = a1; lanes[1].index_B = b1;
+    lanes[2].index_A = a2; lanes[2].index_B = b2;
+    lanes[3].index_A = a3; lanes[3].index_B = b3;
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "libcrypt/rc4/rc4_checkpoints.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+static const char     CHECKPOINTS_MAGIC[4] = { 'R', 'C', '4', 'C' };
+static const uint32_t CHECKPOINTS_VERSION  = 1U;
+
+static void internal_write_uint(std::ofstream& out, uint64_t value, size_t size);
+static bool internal_read_uint(std::ifstream& in, uint64_t& value, size_t size);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+rc4_checkpoints::rc4_checkpoints() {
+    clear();
+}
+
+void rc4_checkpoints::clear() {
+    m_interval = 0U;
+    m_checkpoints.clear();
+}
+
+bool rc4_checkpoints::empty() const {
+    return m_checkpoints.empty();
+}
+
+size_t rc4_checkpoints::get_count() const {
+    return m_checkpoints.size();
+}
+
+uint64_t rc4_checkpoints::get_interval() const {
+    return m_interval;
+}
+
+const rc4_checkpoints::checkpoint* rc4_checkpoints::find(uint64_t offset, uint64_t& checkpoint_offset) const {
+    checkpoint_offset = 0U;
+
+    if (m_checkpoints.empty() || m_interval == 0U)
+        return nullptr;
+
+    uint64_t index = offset / m_interval;
+    if (index >= m_checkpoints.size())
+        index = m_checkpoints.size() - 1;
+
+    checkpoint_offset = index * m_interval;
+    return &m_checkpoints[index];
+}
+
+crypt_result rc4_checkpoints::save(const file_path_t& path) const {
+    crypt_result result;
+
+    std::ofstream out(path, std::ios::binary | std::ios::out);
+    if (!out.is_open()) {
+        result.message = "Failed to open output file.";
+        return result;
+    }
+
+    out.write(CHECKPOINTS_MAGIC, sizeof(CHECKPOINTS_MAGIC));
+    internal_write_uint(out, CHECKPOINTS_VERSION, 4);
+    internal_write_uint(out, m_interval, 8);
+    internal_write_uint(out, m_checkpoints.size(), 8);
+
+    for (const auto& checkpoint : m_checkpoints) {
+        out.write((const char*)checkpoint.box, sizeof(checkpoint.box));
+        out.put((char)checkpoint.index_A);
+        out.put((char)checkpoint.index_B);
+    }
+
+    if (!out) {
+        result.message = "Failed to write output file.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+crypt_result rc4_checkpoints::load(const file_path_t& path) {
+    crypt_result result;
+
+    clear();
+
+    if (!std::filesystem::exists(path)) {
+        result.message = "Input file not found.";
+        return result;
+    }
+
+    std::ifstream in(path, std::ios::binary | std::ios::in);
+    if (!in.is_open()) {
+        result.message = "Failed to open input file.";
+        return result;
+    }
+
+    char     magic[4]{};
+    uint64_t version  = 0U;
+    uint64_t interval = 0U;
+    uint64_t count    = 0U;
+
+    in.read(magic, sizeof(magic));
+
+    if (!in || !std::equal(magic, magic + 4, CHECKPOINTS_MAGIC) ||
+        !internal_read_uint(in, version, 4) || version != CHECKPOINTS_VERSION ||
+        !internal_read_uint(in, interval, 8) || interval == 0U ||
+        !internal_read_uint(in, count, 8))
+    {
+        result.message = "Invalid checkpoints file.";
+        return result;
+    }
+
+    uint64_t file_size = std::filesystem::file_size(path);
+    if (count > file_size / (sizeof(checkpoint::box) + 2)) {
+        result.message = "Invalid checkpoints file.";
+        return result;
+    }
+
+    m_checkpoints.resize(count);
+
+    for (auto& checkpoint : m_checkpoints) {
+        in.read((char*)checkpoint.box, sizeof(checkpoint.box));
+        checkpoint.index_A = (uint8_t)in.get();
+        checkpoint.index_B = (uint8_t)in.get();
+    }
+
+    if (!in) {
+        clear();
+        result.message = "Failed to read input file.";
+        return result;
+    }
+
+    m_interval = interval;
+
+    result.success = true;
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+void internal_write_uint(std::ofstream& out, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        out.put((char)(value & 0xFF));
+        value >>= 8;
+    }
+}
+
+bool internal_read_uint(std::ifstream& in, uint64_t& value, size_t size) {
+    value = 0U;
+
+    for (size_t i = 0; i < size; i++) {
+        int byte = in.get();
+        if (byte == std::char_traits<char>::eof())
+            return false;
+
+        value |= (uint64_t)(uint8_t)byte << (8 * i);
+    }
+
+    return true;
+}
\ No newline at end of file
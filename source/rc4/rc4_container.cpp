@@ -0,0 +1,641 @@
+#include "libcrypt/rc4/rc4_container.hpp"
+#include "libcrypt/md5/md5.hpp"
+#include "libcrypt/misc/thread_pool.hpp"
+#include "misc/mapped_file.hpp"
+#include "rc4/rc4_internal.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+static const char     CONTAINER_MAGIC[4]    = { 'R', 'C', '4', 'B' };
+static const uint32_t CONTAINER_VERSION     = 1U;
+static const size_t   CONTAINER_HEADER_SIZE = 24U;
+
+static void internal_write_uint(uint8_t* ptr, uint64_t value, size_t size);
+static uint64_t internal_read_uint(const uint8_t* ptr, size_t size);
+static uint64_t internal_block_count(uint64_t size, uint32_t block_size);
+
+static void internal_write_header(uint8_t* header, uint32_t block_size, uint64_t payload_size);
+
+// Header must hold CONTAINER_HEADER_SIZE bytes, size is the whole container size
+static bool internal_read_header(const uint8_t* header, uint64_t size, uint32_t& block_size, uint64_t& payload_size);
+
+static crypt_result internal_load_input(const rc4_container::file_path_t& path, mapped_file& mapped,
+    rc4_container::buffer_t& buffer, const uint8_t*& data, size_t& size);
+
+static crypt_result internal_create_output(const rc4_container::file_path_t& path, size_t size,
+    mapped_file& mapped, rc4_container::buffer_t& buffer, uint8_t*& data);
+
+static crypt_result internal_finish_output(const rc4_container::file_path_t& path, mapped_file& mapped,
+    const rc4_container::buffer_t& buffer);
+
+// Checks that output isn't input under another path, symlink or hard link
+static crypt_result internal_check_output(const rc4_container::file_path_t& input, const rc4_container::file_path_t& output);
+
+// Output is written to a temporary file next to it and renamed on success
+static rc4_container::file_path_t internal_temp_path(const rc4_container::file_path_t& output);
+static crypt_result internal_commit_output(const rc4_container::file_path_t& temp, const rc4_container::file_path_t& output);
+static void internal_discard_output(const rc4_container::file_path_t& temp, mapped_file& mapped);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+rc4_container::rc4_container() {
+    m_key          = "";
+    m_iv           = 0U;
+    m_block_size   = DEFAULT_BLOCK_SIZE;
+    m_thread_count = 0U;
+    m_mapped       = std::make_unique<mapped_file>();
+
+    m_open_block_size = 0U;
+    m_open_size       = 0U;
+    m_open            = false;
+}
+
+rc4_container::~rc4_container() {
+    close();
+}
+
+void rc4_container::set_key(const char* key, size_t size) {
+    if (!key) return;
+
+    m_key = internal_parse_key(key, size);
+}
+
+void rc4_container::set_key(const std::string& key) {
+    set_key(key.data(), key.size());
+}
+
+void rc4_container::set_iv(uint8_t iv) {
+    m_iv = iv;
+}
+
+void rc4_container::set_block_size(uint32_t size) {
+    m_block_size = size != 0 ? size : DEFAULT_BLOCK_SIZE;
+}
+
+uint32_t rc4_container::get_block_size() const {
+    return m_block_size;
+}
+
+void rc4_container::set_thread_count(size_t count) {
+    m_thread_count = count;
+}
+
+crypt_result rc4_container::encrypt_file(const file_path_t& input, const file_path_t& output) {
+    crypt_result result;
+
+    if (!std::filesystem::exists(input)) {
+        result.message = "Input file not found.";
+        return result;
+    }
+
+    result = internal_check_output(input, output);
+    if (!result)
+        return result;
+
+    mapped_file    input_mapped;
+    buffer_t       input_buffer;
+    const uint8_t* src  = nullptr;
+    size_t         size = 0U;
+
+    result = internal_load_input(input, input_mapped, input_buffer, src, size);
+    if (!result)
+        return result;
+
+    uint64_t count = internal_block_count(size, m_block_size);
+
+    file_path_t temp = internal_temp_path(output);
+    mapped_file output_mapped;
+    buffer_t    output_buffer;
+    uint8_t*    dst = nullptr;
+
+    result = internal_create_output(temp, CONTAINER_HEADER_SIZE + count * 16 + size,
+        output_mapped, output_buffer, dst);
+
+    if (!result)
+        return result;
+
+    internal_write_header(dst, m_block_size, size);
+
+    result = crypt_blocks(src, dst + CONTAINER_HEADER_SIZE + count * 16, size,
+        (hash_t*)(dst + CONTAINER_HEADER_SIZE), m_block_size, true);
+
+    if (result)
+        result = internal_finish_output(temp, output_mapped, output_buffer);
+
+    if (!result) {
+        internal_discard_output(temp, output_mapped);
+        return result;
+    }
+
+    return internal_commit_output(temp, output);
+}
+
+crypt_result rc4_container::encrypt_buffer(const buffer_t& input, buffer_t& out) {
+    uint64_t count = internal_block_count(input.size(), m_block_size);
+
+    out.resize(CONTAINER_HEADER_SIZE + count * 16 + input.size());
+    internal_write_header(out.data(), m_block_size, input.size());
+
+    return crypt_blocks(input.data(), out.data() + CONTAINER_HEADER_SIZE + count * 16, input.size(),
+        (hash_t*)(out.data() + CONTAINER_HEADER_SIZE), m_block_size, true);
+}
+
+crypt_result rc4_container::decrypt_file(const file_path_t& input, const file_path_t& output) {
+    crypt_result result;
+
+    if (!std::filesystem::exists(input)) {
+        result.message = "Input file not found.";
+        return result;
+    }
+
+    result = internal_check_output(input, output);
+    if (!result)
+        return result;
+
+    mapped_file    input_mapped;
+    buffer_t       input_buffer;
+    const uint8_t* src  = nullptr;
+    size_t         size = 0U;
+
+    result = internal_load_input(input, input_mapped, input_buffer, src, size);
+    if (!result)
+        return result;
+
+    uint32_t block_size   = 0U;
+    uint64_t payload_size = 0U;
+
+    if (!internal_read_header(src, size, block_size, payload_size)) {
+        result.success = false;
+        result.message = "Invalid container file.";
+        return result;
+    }
+
+    uint64_t count = internal_block_count(payload_size, block_size);
+
+    file_path_t temp = internal_temp_path(output);
+    mapped_file output_mapped;
+    buffer_t    output_buffer;
+    uint8_t*    dst = nullptr;
+
+    result = internal_create_output(temp, payload_size, output_mapped, output_buffer, dst);
+    if (!result)
+        return result;
+
+    // Output is left untouched if any block fails its hash check
+    result = crypt_blocks(src + CONTAINER_HEADER_SIZE + count * 16, dst, payload_size,
+        (hash_t*)(src + CONTAINER_HEADER_SIZE), block_size, false);
+
+    if (result)
+        result = internal_finish_output(temp, output_mapped, output_buffer);
+
+    if (!result) {
+        internal_discard_output(temp, output_mapped);
+        return result;
+    }
+
+    return internal_commit_output(temp, output);
+}
+
+crypt_result rc4_container::decrypt_buffer(const buffer_t& input, buffer_t& out) {
+    crypt_result result;
+
+    uint32_t block_size   = 0U;
+    uint64_t payload_size = 0U;
+
+    if (!internal_read_header(input.data(), input.size(), block_size, payload_size)) {
+        result.message = "Invalid container file.";
+        return result;
+    }
+
+    uint64_t count = internal_block_count(payload_size, block_size);
+
+    out.resize(payload_size);
+
+    return crypt_blocks(input.data() + CONTAINER_HEADER_SIZE + count * 16, out.data(), payload_size,
+        (hash_t*)(input.data() + CONTAINER_HEADER_SIZE), block_size, false);
+}
+
+crypt_result rc4_container::open(const file_path_t& path) {
+    crypt_result result;
+
+    close();
+
+    if (!std::filesystem::exists(path)) {
+        result.message = "Input file not found.";
+        return result;
+    }
+
+    uint8_t  header[CONTAINER_HEADER_SIZE]{};
+    uint64_t file_size = 0U;
+
+    if (m_mapped->open(path, false)) {
+        file_size = m_mapped->size();
+
+        if (file_size >= CONTAINER_HEADER_SIZE)
+            std::memcpy(header, m_mapped->data(), CONTAINER_HEADER_SIZE);
+    }
+    else {
+        m_stream.open(path, std::ios::binary | std::ios::in);
+        if (!m_stream.is_open()) {
+            result.message = "Failed to open input file.";
+            return result;
+        }
+
+        file_size = std::filesystem::file_size(path);
+
+        if (file_size >= CONTAINER_HEADER_SIZE)
+            m_stream.read((char*)header, CONTAINER_HEADER_SIZE);
+    }
+
+    uint32_t block_size   = 0U;
+    uint64_t payload_size = 0U;
+
+    if (!internal_read_header(header, file_size, block_size, payload_size)) {
+        close();
+        result.message = "Invalid container file.";
+        return result;
+    }
+
+    uint64_t count = internal_block_count(payload_size, block_size);
+    m_hashes.resize(count);
+
+    if (m_mapped->is_open()) {
+        std::memcpy(m_hashes.data(), m_mapped->data() + CONTAINER_HEADER_SIZE, count * 16);
+    }
+    else {
+        m_stream.read((char*)m_hashes.data(), count * 16);
+
+        if (!m_stream) {
+            close();
+            result.message = "Failed to read input file.";
+            return result;
+        }
+    }
+
+    m_open_block_size = block_size;
+    m_open_size       = payload_size;
+    m_open            = true;
+
+    result.success = true;
+    return result;
+}
+
+void rc4_container::close() {
+    m_mapped->close();
+
+    if (m_stream.is_open())
+        m_stream.close();
+
+    m_stream.clear();
+    m_hashes.clear();
+
+    m_open_block_size = 0U;
+    m_open_size       = 0U;
+    m_open            = false;
+}
+
+bool rc4_container::is_open() const {
+    return m_open;
+}
+
+uint64_t rc4_container::get_size() const {
+    return m_open_size;
+}
+
+crypt_result rc4_container::read(uint8_t* ptr, size_t size, uint64_t offset) {
+    crypt_result result;
+
+    if (!m_open) {
+        result.message = "Container not open.";
+        return result;
+    }
+
+    if (offset > m_open_size || size > m_open_size - offset) {
+        result.message = "Read out of range.";
+        return result;
+    }
+
+    uint64_t payload_offset = CONTAINER_HEADER_SIZE + m_hashes.size() * 16;
+
+    buffer_t block;
+    buffer_t plain;
+    md5      md5;
+
+    while (size > 0) {
+        uint64_t index = offset / m_open_block_size;
+        size_t   start = (size_t)(offset % m_open_block_size);
+        size_t   full  = (size_t)std::min<uint64_t>(m_open_block_size, m_open_size - index * m_open_block_size);
+        size_t   count = std::min(size, full - start);
+
+        const uint8_t* src = nullptr;
+
+        if (m_mapped->is_open()) {
+            src = m_mapped->data() + payload_offset + index * m_open_block_size;
+        }
+        else {
+            block.resize(full);
+
+            std::lock_guard<std::mutex> lock(m_stream_mutex);
+
+            m_stream.seekg((std::streamoff)(payload_offset + index * m_open_block_size));
+            m_stream.read((char*)block.data(), full);
+
+            if (!m_stream) {
+                m_stream.clear();
+                result.message = "Failed to read input file.";
+                return result;
+            }
+
+            src = block.data();
+        }
+
+        if (md5.compute(src, full) != m_hashes[index]) {
+            result.message = "Block hash mismatch.";
+            return result;
+        }
+
+        // Keystream of a block starts at its first byte
+        plain.resize(start + count);
+        crypt_block(src, plain.data(), start + count, index);
+        std::memcpy(ptr, plain.data() + start, count);
+
+        ptr    += count;
+        offset += count;
+        size   -= count;
+    }
+
+    result.success = true;
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+crypt_result rc4_container::crypt_blocks(const uint8_t* src, uint8_t* dst, uint64_t size,
+    hash_t* hashes, uint32_t block_size, bool encrypt) const
+{
+    crypt_result result;
+
+    uint64_t          count = internal_block_count(size, block_size);
+    std::atomic<bool> failed{ false };
+
+    auto crypt_one = [&](uint64_t index) {
+        uint64_t       offset = index * block_size;
+        size_t         length = (size_t)std::min<uint64_t>(block_size, size - offset);
+        const uint8_t* in     = src + offset;
+        uint8_t*       out    = dst + offset;
+        md5            md5;
+
+        if (!encrypt && md5.compute(in, length) != hashes[index]) {
+            failed = true;
+            return;
+        }
+
+        crypt_block(in, out, length, index);
+
+        if (encrypt)
+            hashes[index] = md5.compute(out, length);
+    };
+
+    if (count <= 1 || m_thread_count == 1) {
+        for (uint64_t i = 0; i < count && !failed; i++)
+            crypt_one(i);
+    }
+    else {
+        thread_pool pool(m_thread_count);
+
+        for (uint64_t i = 0; i < count; i++) {
+            pool.submit([&, i]() {
+                if (!failed)
+                    crypt_one(i);
+            });
+        }
+
+        pool.wait();
+    }
+
+    if (failed) {
+        result.message = "Block hash mismatch.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+void rc4_container::crypt_block(const uint8_t* src, uint8_t* dst, size_t size, uint64_t index) const {
+    uint8_t index_bytes[8]{};
+    internal_write_uint(index_bytes, index, 8);
+
+    md5 md5;
+    md5.update(m_key.data(), m_key.size());
+    md5.update(&m_iv, 1);
+    md5.update(index_bytes, sizeof(index_bytes));
+
+    auto        digest = md5.finalize();
+    std::string key((const char*)digest.data(), digest.size());
+
+    uint8_t  box[256];
+    uint32_t index_A = 0U;
+    uint32_t index_B = 0U;
+
+    internal_generate_box(box, key, m_iv);
+    internal_crypt(box, index_A, index_B, src, dst, size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+void internal_write_uint(uint8_t* ptr, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        ptr[i] = (uint8_t)(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+uint64_t internal_read_uint(const uint8_t* ptr, size_t size) {
+    uint64_t value = 0U;
+
+    for (size_t i = 0; i < size; i++)
+        value |= (uint64_t)ptr[i] << (8 * i);
+
+    return value;
+}
+
+uint64_t internal_block_count(uint64_t size, uint32_t block_size) {
+    return size / block_size + (size % block_size != 0 ? 1 : 0);
+}
+
+void internal_write_header(uint8_t* header, uint32_t block_size, uint64_t payload_size) {
+    std::memcpy(header, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+    internal_write_uint(header + 4,  CONTAINER_VERSION, 4);
+    internal_write_uint(header + 8,  block_size, 4);
+    internal_write_uint(header + 12, 0U, 4);
+    internal_write_uint(header + 16, payload_size, 8);
+}
+
+bool internal_read_header(const uint8_t* header, uint64_t size, uint32_t& block_size, uint64_t& payload_size) {
+    if (size < CONTAINER_HEADER_SIZE || !std::equal(header, header + 4, (const uint8_t*)CONTAINER_MAGIC))
+        return false;
+
+    if (internal_read_uint(header + 4, 4) != CONTAINER_VERSION)
+        return false;
+
+    block_size   = (uint32_t)internal_read_uint(header + 8, 4);
+    payload_size = internal_read_uint(header + 16, 8);
+
+    if (block_size == 0U || payload_size > size)
+        return false;
+
+    return size == CONTAINER_HEADER_SIZE + internal_block_count(payload_size, block_size) * 16 + payload_size;
+}
+
+crypt_result internal_load_input(const rc4_container::file_path_t& path, mapped_file& mapped,
+    rc4_container::buffer_t& buffer, const uint8_t*& data, size_t& size)
+{
+    crypt_result result = mapped.open(path, false);
+
+    if (result) {
+        data = mapped.data();
+        size = mapped.size();
+        return result;
+    }
+
+    result.message = "";
+
+    std::ifstream in(path, std::ios::binary | std::ios::in);
+    if (!in.is_open()) {
+        result.message = "Failed to open input file.";
+        return result;
+    }
+
+    buffer.resize((size_t)std::filesystem::file_size(path));
+    in.read((char*)buffer.data(), buffer.size());
+
+    if (!in) {
+        result.message = "Failed to read input file.";
+        return result;
+    }
+
+    data = buffer.data();
+    size = buffer.size();
+
+    result.success = true;
+    return result;
+}
+
+crypt_result internal_create_output(const rc4_container::file_path_t& path, size_t size,
+    mapped_file& mapped, rc4_container::buffer_t& buffer, uint8_t*& data)
+{
+    crypt_result result;
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!out.is_open()) {
+            result.message = "Failed to open output file.";
+            return result;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::resize_file(path, size, error);
+
+    // Blocks are written straight into the mapped output, empty files can't
+    // be mapped and other failures fall back to a buffer written at the end
+    if (!error && size != 0 && mapped.open(path, true)) {
+        data = mapped.data();
+    }
+    else {
+        mapped.close();
+        buffer.resize(size);
+        data = buffer.data();
+    }
+
+    result.success = true;
+    return result;
+}
+
+crypt_result internal_finish_output(const rc4_container::file_path_t& path, mapped_file& mapped,
+    const rc4_container::buffer_t& buffer)
+{
+    crypt_result result;
+
+    if (mapped.is_open()) {
+        mapped.close();
+
+        result.success = true;
+        return result;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        result.message = "Failed to open output file.";
+        return result;
+    }
+
+    out.write((const char*)buffer.data(), buffer.size());
+
+    if (!out) {
+        result.message = "Failed to write output file.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+crypt_result internal_check_output(const rc4_container::file_path_t& input, const rc4_container::file_path_t& output) {
+    crypt_result result;
+
+    if (output.empty()) {
+        result.message = "Failed to open output file.";
+        return result;
+    }
+
+    std::error_code error;
+    if (std::filesystem::exists(output, error) && std::filesystem::equivalent(input, output, error)) {
+        result.message = "Output file is the input file.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+rc4_container::file_path_t internal_temp_path(const rc4_container::file_path_t& output) {
+    rc4_container::file_path_t temp = output;
+    temp += ".tmp";
+
+    return temp;
+}
+
+crypt_result internal_commit_output(const rc4_container::file_path_t& temp, const rc4_container::file_path_t& output) {
+    crypt_result result;
+
+    std::error_code error;
+    std::filesystem::rename(temp, output, error);
+
+    if (error) {
+        std::filesystem::remove(temp, error);
+
+        result.message = "Failed to write output file.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+void internal_discard_output(const rc4_container::file_path_t& temp, mapped_file& mapped) {
+    mapped.close();
+
+    std::error_code error;
+    std::filesystem::remove(temp, error);
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "libcrypt/rc4/rc4_cursor.hpp"
+#include "rc4/rc4_internal.hpp"
+
+#include <cstring>
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+rc4_cursor::rc4_cursor(rc4_key_schedule::ptr_t schedule)
+    : m_schedule(std::move(schedule))
+{
+    reset();
+}
+
+void rc4_cursor::reset() {
+    m_index_A = 0;
+    m_index_B = 0;
+    m_offset  = 0;
+
+    std::memcpy(m_box, m_schedule->get_box(), sizeof(m_box));
+}
+
+void rc4_cursor::seek(uint64_t offset, const rc4_checkpoints* checkpoints) {
+    uint64_t checkpoint_offset = 0U;
+
+    // First checkpoint is the initial box, if it doesn't match the
+    // checkpoints were built for a different key or iv
+    const auto* first = checkpoints ? checkpoints->find(0U, checkpoint_offset) : nullptr;
+
+    if (first && std::memcmp(first->box, m_schedule->get_box(), sizeof(m_box)) == 0) {
+        const auto* nearest = checkpoints->find(offset, checkpoint_offset);
+
+        if (offset < m_offset || checkpoint_offset > m_offset) {
+            std::memcpy(m_box, nearest->box, sizeof(m_box));
+            m_index_A = nearest->index_A;
+            m_index_B = nearest->index_B;
+            m_offset  = checkpoint_offset;
+        }
+    }
+
+    if (offset < m_offset)
+        reset();
+
+    internal_skip(m_box, m_index_A, m_index_B, offset - m_offset);
+    m_offset = offset;
+}
+
+uint64_t rc4_cursor::get_offset() const {
+    return m_offset;
+}
+
+const rc4_key_schedule::ptr_t& rc4_cursor::get_schedule() const {
+    return m_schedule;
+}
+
+rc4_checkpoints::checkpoint rc4_cursor::get_state() const {
+    rc4_checkpoints::checkpoint state{};
+
+    std::memcpy(state.box, m_box, sizeof(m_box));
+    state.index_A = (uint8_t)m_index_A;
+    state.index_B = (uint8_t)m_index_B;
+
+    return state;
+}
+
+void rc4_cursor::set_state(const rc4_checkpoints::checkpoint& state, uint64_t offset) {
+    std::memcpy(m_box, state.box, sizeof(m_box));
+    m_index_A = state.index_A;
+    m_index_B = state.index_B;
+    m_offset  = offset;
+}
+
+crypt_result rc4_cursor::crypt(uint8_t* ptr, size_t size) {
+    return crypt(ptr, ptr, size);
+}
+
+crypt_result rc4_cursor::crypt(const uint8_t* src, uint8_t* dst, size_t size) {
+    crypt_result result;
+
+    internal_crypt(m_box, m_index_A, m_index_B, src, dst, size);
+    m_offset += size;
+
+    result.success = true;
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "libcrypt/rc4/detail/rc4_schedule.hpp"
+#include "misc/kernel_table.hpp"
+
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+
+#ifndef _MSC_VER
+    #include <endian.h>
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RC4 key schedule and keystream helpers shared by rc4, rc4_key_schedule
+// and rc4_cursor.
+
+static inline std::string internal_hex_string_to_string(const std::string& hex_string) {
+    std::string hex_data = hex_string.substr(2);
+
+    if (hex_data.length() % 2 != 0)
+        hex_data = '0' + hex_data;
+
+    std::stringstream ss;
+    for (size_t i = 0; i < hex_data.length(); i += 2)
+        ss << static_cast<char>(std::stoi(hex_data.substr(i, 2), nullptr, 16));
+
+    return ss.str();
+}
+
+static inline std::string internal_parse_key(const char* key, size_t size) {
+    if (size >= 2 && key[0] == '0' && (key[1] == 'x' || key[1] == 'X'))
+        return internal_hex_string_to_string(std::string(key, key + size));
+
+    return std::string(key, key + size);
+}
+
+static inline void internal_swap(uint8_t* buffer, uint32_t i, uint32_t j) {
+    uint8_t temp = buffer[i];
+    buffer[i]    = buffer[j];
+    buffer[j]    = temp;
+}
+
+static inline void internal_generate_box(uint8_t* box, const std::string& key, uint8_t iv) {
+    libcrypt::detail::rc4_generate_box(box, key.data(), key.size(), iv);
+}
+
+// Advances the keystream by count bytes without producing output.
+static inline void internal_skip(uint8_t* box, uint32_t& index_A, uint32_t& index_B, uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        index_A = (index_A + 1) % 256;
+        index_B = (index_B + box[index_A]) % 256;
+        internal_swap(box, index_A, index_B);
+    }
+}
+
+// Size of the keystream block generated ahead of the XOR
+static const size_t KEYSTREAM_BLOCK_SIZE = 4096;
+
+// Below this size the box isn't widened and bytes are crypted directly
+static const size_t KEYSTREAM_MIN_SIZE = 256;
+
+// Writes size bytes of keystream to out.
+// Box is widened to uint32_t, byte sized box entries stall on partial
+// register writes and store forwarding. Output is packed 8 bytes at a time.
+static inline void internal_keystream(uint32_t* box, uint32_t& index_A, uint32_t& index_B,
+    uint8_t* out, size_t size)
+{
+    uint32_t a = index_A;
+    uint32_t b = index_B;
+    uint32_t x, y;
+
+#define LIBCRYPT_RC4_STEP(shift)               \
+    a      = (a + 1) & 0xFF;                   \
+    x      = box[a];                           \
+    b      = (b + x) & 0xFF;                   \
+    y      = box[b];                           \
+    box[a] = y;                                \
+    box[b] = x;                                \
+    word  |= (uint64_t)box[(x + y) & 0xFF] << (shift);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word = 0U;
+
+        LIBCRYPT_RC4_STEP(0);
+        LIBCRYPT_RC4_STEP(8);
+        LIBCRYPT_RC4_STEP(16);
+        LIBCRYPT_RC4_STEP(24);
+        LIBCRYPT_RC4_STEP(32);
+        LIBCRYPT_RC4_STEP(40);
+        LIBCRYPT_RC4_STEP(48);
+        LIBCRYPT_RC4_STEP(56);
+
+#if defined(__BYTE_ORDER) && (__BYTE_ORDER != 0) && (__BYTE_ORDER == __BIG_ENDIAN)
+        word = __builtin_bswap64(word);
+#endif
+
+        std::memcpy(out + i, &word, sizeof(word));
+    }
+
+    for (; i < size; i++) {
+        uint64_t word = 0U;
+
+        LIBCRYPT_RC4_STEP(0);
+
+        out[i] = (uint8_t)word;
+    }
+
+#undef LIBCRYPT_RC4_STEP
+
+    index_A = a;
+    index_B = b;
+}
+
+// XORs size bytes of keystream with src into dst, src and dst may be equal.
+static inline void internal_xor(const uint8_t* src, const uint8_t* keystream, uint8_t* dst, size_t size) {
+    libcrypt::kernel_table::get().rc4_xor(src, keystream, dst, size);
+}
+
+// XORs size bytes of keystream with src into dst, src and dst may be equal.
+// Box is already widened, lets callers crypting many ranges widen it once.
+static inline void internal_crypt_wide(uint32_t* wide_box, uint32_t& index_A, uint32_t& index_B,
+    const uint8_t* src, uint8_t* dst, size_t size)
+{
+    alignas(64) uint8_t keystream[KEYSTREAM_BLOCK_SIZE];
+
+    while (size > 0) {
+        size_t block = size < KEYSTREAM_BLOCK_SIZE ? size : KEYSTREAM_BLOCK_SIZE;
+
+        internal_keystream(wide_box, index_A, index_B, keystream, block);
+        internal_xor(src, keystream, dst, block);
+
+        src  += block;
+        dst  += block;
+        size -= block;
+    }
+}
+
+// XORs size bytes of keystream with src into dst, src and dst may be equal.
+// Keystream is generated in blocks ahead of the vectorized XOR.
+static inline void internal_crypt(uint8_t* box, uint32_t& index_A, uint32_t& index_B,
+    const uint8_t* src, uint8_t* dst, size_t size)
+{
+    if (size < KEYSTREAM_MIN_SIZE) {
+        uint8_t a = (uint8_t)index_A;
+        uint8_t b = (uint8_t)index_B;
+
+        for (size_t i = 0; i < size; i++) {
+            a++;
+            uint8_t x = box[a];
+            b += x;
+            uint8_t y = box[b];
+            box[a] = y;
+            box[b] = x;
+            dst[i] = box[(uint8_t)(x + y)] ^ src[i];
+        }
+
+        index_A = a;
+        index_B = b;
+        return;
+    }
+
+    uint32_t wide_box[256];
+
+    for (int i = 0; i < 256; i++)
+        wide_box[i] = box[i];
+
+    internal_crypt_wide(wide_box, index_A, index_B, src, dst, size);
+
+    for (int i = 0; i < 256; i++)
+        box[i] = (uint8_t)wide_box[i];
+}
\ No newline at end of file
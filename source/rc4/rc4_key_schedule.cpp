@@ -0,0 +1,62 @@
+#include "libcrypt/rc4/rc4_key_schedule.hpp"
+#include "rc4/rc4_internal.hpp"
+
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+static std::shared_mutex cache_mutex;
+static std::unordered_map<std::string, rc4_key_schedule::ptr_t> cache;
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+rc4_key_schedule::rc4_key_schedule(const char* key, size_t size, uint8_t iv) {
+    m_key = key ? internal_parse_key(key, size) : "";
+    m_iv  = iv;
+
+    internal_generate_box(m_box, m_key, m_iv);
+}
+
+rc4_key_schedule::rc4_key_schedule(const std::string& key, uint8_t iv)
+    : rc4_key_schedule(key.data(), key.size(), iv) {}
+
+rc4_key_schedule::ptr_t rc4_key_schedule::get(const std::string& key, uint8_t iv) {
+    std::string cache_key = key;
+    cache_key += (char)iv;
+
+    {
+        std::shared_lock lock(cache_mutex);
+
+        auto it = cache.find(cache_key);
+        if (it != cache.end())
+            return it->second;
+    }
+
+    auto schedule = std::make_shared<const rc4_key_schedule>(key, iv);
+
+    std::unique_lock lock(cache_mutex);
+    return cache.emplace(std::move(cache_key), std::move(schedule)).first->second;
+}
+
+void rc4_key_schedule::clear_cache() {
+    std::unique_lock lock(cache_mutex);
+    cache.clear();
+}
+
+const std::string& rc4_key_schedule::get_key() const {
+    return m_key;
+}
+
+uint8_t rc4_key_schedule::get_iv() const {
+    return m_iv;
+}
+
+const uint8_t* rc4_key_schedule::get_box() const {
+    return m_box;
+}
\ No newline at end of file
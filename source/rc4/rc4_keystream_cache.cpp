@@ -0,0 +1,272 @@
+#include "libcrypt/rc4/rc4_keystream_cache.hpp"
+#include "libcrypt/rc4/rc4_cursor.hpp"
+#include "libcrypt/misc/thread_pool.hpp"
+#include "rc4/rc4_internal.hpp"
+#include "misc/mapped_file.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+static const char   KEYSTREAM_MAGIC[4] = { 'R', 'C', '4', 'K' };
+static const size_t KEYSTREAM_HEADER   = 4 + 8 + 256 + 2;
+static const size_t KEYSTREAM_VERIFY   = 64;
+static const size_t THREAD_MIN_SIZE    = 1 << 20;
+
+static void internal_parallel_xor(thread_pool& pool, const uint8_t* keystream, const uint8_t* src, uint8_t* dst, size_t size, size_t parts);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+rc4_keystream_cache::rc4_keystream_cache() {
+    m_thread_count = 0U;
+
+    clear();
+}
+
+rc4_keystream_cache::~rc4_keystream_cache() {}
+
+crypt_result rc4_keystream_cache::build(rc4_key_schedule::ptr_t schedule, size_t length) {
+    crypt_result result;
+
+    clear();
+
+    if (!schedule) {
+        result.message = "Key schedule not set.";
+        return result;
+    }
+
+    rc4_cursor cursor(schedule);
+
+    // Keystream is the encryption of zeroes
+    m_buffer.assign(length, 0U);
+    cursor.crypt(m_buffer.data(), m_buffer.size());
+
+    m_schedule  = std::move(schedule);
+    m_keystream = m_buffer.data();
+    m_length    = length;
+    m_end_state = cursor.get_state();
+
+    m_tail_state  = m_end_state;
+    m_tail_offset = m_length;
+
+    result.success = true;
+    return result;
+}
+
+crypt_result rc4_keystream_cache::save(const file_path_t& path) const {
+    crypt_result result;
+
+    if (!m_schedule) {
+        result.message = "Keystream not built.";
+        return result;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::out);
+    if (!out.is_open()) {
+        result.message = "Failed to open output file.";
+        return result;
+    }
+
+    uint64_t length = m_length;
+
+    out.write(KEYSTREAM_MAGIC, sizeof(KEYSTREAM_MAGIC));
+
+    for (int i = 0; i < 8; i++) {
+        out.put((char)(length & 0xFF));
+        length >>= 8;
+    }
+
+    out.write((const char*)m_end_state.box, sizeof(m_end_state.box));
+    out.put((char)m_end_state.index_A);
+    out.put((char)m_end_state.index_B);
+    out.write((const char*)m_keystream, m_length);
+
+    if (!out) {
+        result.message = "Failed to write output file.";
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+crypt_result rc4_keystream_cache::load(rc4_key_schedule::ptr_t schedule, const file_path_t& path) {
+    crypt_result result;
+
+    clear();
+
+    if (!schedule) {
+        result.message = "Key schedule not set.";
+        return result;
+    }
+
+    if (!std::filesystem::exists(path)) {
+        result.message = "Input file not found.";
+        return result;
+    }
+
+    auto mapping = std::make_unique<mapped_file>();
+
+    result = mapping->open(path, false);
+    if (!result)
+        return result;
+
+    result.success = false;
+
+    const uint8_t* data = mapping->data();
+    size_t         size = mapping->size();
+
+    uint64_t length = 0U;
+    if (size >= KEYSTREAM_HEADER) {
+        for (int i = 7; i >= 0; i--)
+            length = (length << 8) | data[4 + i];
+    }
+
+    if (size < KEYSTREAM_HEADER || !std::equal(data, data + 4, KEYSTREAM_MAGIC) ||
+        length != size - KEYSTREAM_HEADER)
+    {
+        result.message = "Invalid keystream file.";
+        return result;
+    }
+
+    // Keystream must belong to the key schedule, compare its start
+    uint8_t verify[KEYSTREAM_VERIFY]{};
+    size_t  verify_size = std::min<size_t>(KEYSTREAM_VERIFY, (size_t)length);
+
+    rc4_cursor cursor(schedule);
+    cursor.crypt(verify, verify_size);
+
+    if (!std::equal(verify, verify + verify_size, data + KEYSTREAM_HEADER)) {
+        result.message = "Keystream doesn't match key schedule.";
+        return result;
+    }
+
+    std::memcpy(m_end_state.box, data + 12, sizeof(m_end_state.box));
+    m_end_state.index_A = data[12 + 256];
+    m_end_state.index_B = data[12 + 257];
+
+    m_schedule  = std::move(schedule);
+    m_keystream = data + KEYSTREAM_HEADER;
+    m_length    = (size_t)length;
+    m_mapping   = std::move(mapping);
+
+    m_tail_state  = m_end_state;
+    m_tail_offset = m_length;
+
+    result.success = true;
+    return result;
+}
+
+void rc4_keystream_cache::clear() {
+    m_schedule.reset();
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_mapping.reset();
+
+    m_keystream = nullptr;
+    m_length    = 0U;
+    m_end_state = {};
+
+    m_tail_state  = {};
+    m_tail_offset = 0U;
+}
+
+size_t rc4_keystream_cache::get_length() const {
+    return m_length;
+}
+
+void rc4_keystream_cache::set_thread_count(size_t count) {
+    m_thread_count = count;
+    m_pool.reset();
+}
+
+crypt_result rc4_keystream_cache::crypt(uint8_t* ptr, size_t size, uint64_t offset) const {
+    return crypt(ptr, ptr, size, offset);
+}
+
+crypt_result rc4_keystream_cache::crypt(const uint8_t* src, uint8_t* dst, size_t size, uint64_t offset) const {
+    crypt_result result;
+
+    if (!m_schedule) {
+        result.message = "Keystream not built.";
+        return result;
+    }
+
+    if (offset < m_length) {
+        size_t cached = (size_t)std::min<uint64_t>(size, m_length - offset);
+
+        // Small ranges aren't worth waking the pool
+        size_t thread_count = m_thread_count != 0 ? m_thread_count : std::thread::hardware_concurrency();
+        size_t parts        = std::min(thread_count, cached / THREAD_MIN_SIZE);
+
+        if (parts > 1) {
+            std::lock_guard lock(m_pool_mutex);
+
+            // Calling thread takes one part
+            if (!m_pool)
+                m_pool = std::make_unique<thread_pool>(thread_count - 1);
+
+            internal_parallel_xor(*m_pool, m_keystream + offset, src, dst, cached, parts);
+        }
+        else {
+            internal_xor(src, m_keystream + offset, dst, cached);
+        }
+
+        src    += cached;
+        dst    += cached;
+        size   -= cached;
+        offset += cached;
+    }
+
+    if (size != 0) {
+        rc4_cursor cursor(m_schedule);
+
+        {
+            std::lock_guard lock(m_tail_mutex);
+
+            if (offset >= m_tail_offset)
+                cursor.set_state(m_tail_state, m_tail_offset);
+            else
+                cursor.set_state(m_end_state, m_length);
+        }
+
+        cursor.seek(offset);
+        cursor.crypt(src, dst, size);
+
+        std::lock_guard lock(m_tail_mutex);
+
+        if (cursor.get_offset() > m_tail_offset) {
+            m_tail_state  = cursor.get_state();
+            m_tail_offset = cursor.get_offset();
+        }
+    }
+
+    result.success = true;
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+void internal_parallel_xor(thread_pool& pool, const uint8_t* keystream, const uint8_t* src, uint8_t* dst, size_t size, size_t parts) {
+    size_t part = size / parts;
+
+    for (size_t i = 1; i < parts; i++) {
+        size_t start = i * part;
+        size_t end   = i + 1 == parts ? size : start + part;
+
+        pool.submit([=]() {
+            internal_xor(src + start, keystream + start, dst + start, end - start);
+        });
+    }
+
+    internal_xor(src, keystream, dst, part);
+
+    pool.wait();
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "libcrypt/rc4/rc4_streambuf.hpp"
+
+#include <cstring>
+
+using namespace libcrypt;
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+rc4_streambuf::rc4_streambuf(std::streambuf* inner, rc4& rc4, size_t buffer_size, std::ios_base::openmode which)
+    : m_inner(inner), m_rc4(rc4)
+{
+    if (buffer_size == 0U)
+        buffer_size = DEFAULT_BUFFER_SIZE;
+
+    m_get.resize(buffer_size);
+    m_put.resize(buffer_size);
+    m_encrypted.resize(buffer_size);
+    m_origin   = 0U;
+    m_position = 0U;
+
+    // Buffers with separate positions can't report both at once
+    if (m_inner) {
+        pos_type origin = m_inner->pubseekoff(0, std::ios_base::cur, which);
+
+        if (origin == pos_type(off_type(-1)) && (which & std::ios_base::in))
+            origin = m_inner->pubseekoff(0, std::ios_base::cur, std::ios_base::in);
+
+        if (origin == pos_type(off_type(-1)) && (which & std::ios_base::out))
+            origin = m_inner->pubseekoff(0, std::ios_base::cur, std::ios_base::out);
+
+        // Unseekable buffers start at 0
+        if (origin != pos_type(off_type(-1)))
+            m_origin = (uint64_t)off_type(origin);
+    }
+
+    m_rc4.reset();
+
+    // Only one of the areas is active at a time
+    setg(nullptr, nullptr, nullptr);
+    setp(nullptr, nullptr);
+}
+
+rc4_streambuf::~rc4_streambuf() {
+    flush_put();
+    m_rc4.reset();
+}
+
+rc4_istream::rc4_istream(std::istream& inner, rc4& rc4, size_t buffer_size)
+    : std::istream(nullptr), m_buffer(inner.rdbuf(), rc4, buffer_size, std::ios_base::in)
+{
+    rdbuf(&m_buffer);
+}
+
+rc4_ostream::rc4_ostream(std::ostream& inner, rc4& rc4, size_t buffer_size)
+    : std::ostream(nullptr), m_buffer(inner.rdbuf(), rc4, buffer_size, std::ios_base::out)
+{
+    rdbuf(&m_buffer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PROTECTED
+
+rc4_streambuf::int_type rc4_streambuf::underflow() {
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    if (!m_inner || !flush_put())
+        return traits_type::eof();
+
+    std::streamsize count = m_inner->sgetn(m_get.data(), (std::streamsize)m_get.size());
+    if (count <= 0) {
+        setg(nullptr, nullptr, nullptr);
+        return traits_type::eof();
+    }
+
+    m_rc4.decrypt_stream((uint8_t*)m_get.data(), (size_t)count, m_position);
+    m_position += (uint64_t)count;
+
+    setg(m_get.data(), m_get.data(), m_get.data() + count);
+    return traits_type::to_int_type(*gptr());
+}
+
+rc4_streambuf::int_type rc4_streambuf::overflow(int_type ch) {
+    if (!m_inner || !drop_get() || !flush_put())
+        return traits_type::eof();
+
+    setp(m_put.data(), m_put.data() + m_put.size());
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+int rc4_streambuf::sync() {
+    if (!m_inner || !flush_put())
+        return -1;
+
+    return m_inner->pubsync();
+}
+
+rc4_streambuf::pos_type rc4_streambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+    if (!m_inner)
+        return pos_type(off_type(-1));
+
+    // Logical position accounts for read ahead and unwritten data
+    uint64_t current = m_position - (uint64_t)(egptr() - gptr()) + (uint64_t)(pptr() - pbase());
+
+    if (dir == std::ios_base::cur && off == 0)
+        return pos_type((off_type)current);
+
+    if (dir == std::ios_base::beg)
+        return seekpos(pos_type(off), which);
+
+    if (dir == std::ios_base::cur)
+        return seekpos(pos_type((off_type)current + off), which);
+
+    if (!flush_put())
+        return pos_type(off_type(-1));
+
+    pos_type end = m_inner->pubseekoff(0, std::ios_base::end, which);
+    if (end == pos_type(off_type(-1)) || (uint64_t)off_type(end) < m_origin)
+        return pos_type(off_type(-1));
+
+    return seekpos(pos_type(off_type(end) - (off_type)m_origin + off), which);
+}
+
+rc4_streambuf::pos_type rc4_streambuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    if (!m_inner || off_type(pos) < 0 || !flush_put())
+        return pos_type(off_type(-1));
+
+    pos_type result = m_inner->pubseekpos(pos_type((off_type)m_origin + off_type(pos)), which);
+    if (result == pos_type(off_type(-1)))
+        return result;
+
+    // Next read or write crypts from the new offset
+    m_position = (uint64_t)off_type(result) - m_origin;
+    setg(nullptr, nullptr, nullptr);
+
+    return pos_type((off_type)m_position);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+bool rc4_streambuf::flush_put() {
+    size_t count = (size_t)(pptr() - pbase());
+
+    if (count != 0U) {
+        if (!m_inner)
+            return false;
+
+        // Encrypted into a scratch buffer so a failed write can be retried
+        m_rc4.encrypt_stream((const uint8_t*)pbase(), (uint8_t*)m_encrypted.data(), count, m_position);
+
+        std::streamsize written = m_inner->sputn(m_encrypted.data(), (std::streamsize)count);
+        if (written < 0)
+            written = 0;
+
+        m_position += (uint64_t)written;
+
+        if ((size_t)written != count) {
+            // Keep the unwritten tail at the start of the put area
+            std::memmove(pbase(), pbase() + written, count - (size_t)written);
+
+            setp(m_put.data(), m_put.data() + m_put.size());
+            pbump((int)(count - (size_t)written));
+            return false;
+        }
+    }
+
+    setp(nullptr, nullptr);
+    return true;
+}
+
+bool rc4_streambuf::drop_get() {
+    size_t ahead = (size_t)(egptr() - gptr());
+
+    if (ahead != 0U) {
+        uint64_t current = m_position - ahead;
+
+        if (m_inner->pubseekpos(pos_type((off_type)(m_origin + current))) == pos_type(off_type(-1)))
+            return false;
+
+        m_position = current;
+    }
+
+    setg(nullptr, nullptr, nullptr);
+    return true;
+}
\ No newline at end of file
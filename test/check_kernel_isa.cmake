@@ -0,0 +1,43 @@
+# Checks that the scalar and sse2 kernels in the library don't contain avx or
+# bmi instructions and don't reference shared copies of the md5 rounds that
+# the linker could swap for one built with wider isa flags.
+#
+# Usage: cmake -DOBJDUMP=<objdump> -DNM=<nm> -DLIBRARY=<libcrypt.a> -P check_kernel_isa.cmake
+
+SET(KERNELS "kernels_scalar.cpp" "kernels_sse2.cpp")
+SET(FORBIDDEN "[ \t](rorx|andn|shlx|shrx|sarx|bzhi|pdep|pext)[ \t]|%[yz]mm")
+
+FUNCTION(SPLIT_MEMBERS OUTPUT MEMBER RESULT)
+	STRING(FIND "${OUTPUT}" "${MEMBER}" BEGIN)
+	IF(BEGIN EQUAL -1)
+		MESSAGE(FATAL_ERROR "${MEMBER} not found in ${LIBRARY}")
+	ENDIF()
+
+	STRING(SUBSTRING "${OUTPUT}" ${BEGIN} -1 REST)
+	STRING(REGEX REPLACE "\n\n[^\n]+\\.o:.*" "" REST "${REST}")
+	SET(${RESULT} "${REST}" PARENT_SCOPE)
+ENDFUNCTION()
+
+EXECUTE_PROCESS(COMMAND "${OBJDUMP}" -d --no-show-raw-insn "${LIBRARY}" OUTPUT_VARIABLE DISASSEMBLY RESULT_VARIABLE STATUS)
+IF(NOT STATUS EQUAL 0)
+	MESSAGE(FATAL_ERROR "objdump failed on ${LIBRARY}")
+ENDIF()
+
+EXECUTE_PROCESS(COMMAND "${NM}" -C "${LIBRARY}" OUTPUT_VARIABLE SYMBOLS RESULT_VARIABLE STATUS)
+IF(NOT STATUS EQUAL 0)
+	MESSAGE(FATAL_ERROR "nm failed on ${LIBRARY}")
+ENDIF()
+
+FOREACH(KERNEL ${KERNELS})
+	SPLIT_MEMBERS("${DISASSEMBLY}" "${KERNEL}" CODE)
+	STRING(REGEX MATCH "[^\n]*(${FORBIDDEN})[^\n]*" MATCH "${CODE}")
+	IF(MATCH)
+		MESSAGE(FATAL_ERROR "${KERNEL} uses instructions above its isa:\n${MATCH}")
+	ENDIF()
+
+	SPLIT_MEMBERS("${SYMBOLS}" "${KERNEL}" NAMES)
+	STRING(REGEX MATCH "[^\n]* [WUV] [^\n]*libcrypt::detail::[^\n]*" MATCH "${NAMES}")
+	IF(MATCH)
+		MESSAGE(FATAL_ERROR "${KERNEL} shares md5 rounds with other kernels:\n${MATCH}")
+	ENDIF()
+ENDFOREACH()
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include <libcrypt.hpp>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+
+using namespace libcrypt;
+
+static std::vector<uint8_t> make_buffer(size_t size, uint8_t seed) {
+    std::vector<uint8_t> buffer(size);
+    for (size_t i = 0; i < size; i++)
+        buffer[i] = (uint8_t)(i * 13 + seed);
+
+    return buffer;
+}
+
+static std::vector<uint8_t> read_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static void write_file(const std::filesystem::path& path, const std::vector<uint8_t>& buffer) {
+    std::filesystem::create_directories(path.parent_path());
+
+    std::ofstream out(path, std::ios::binary);
+    out.write((const char*)buffer.data(), buffer.size());
+}
+
+TEST(job, thread_pool_runs_all_tasks) {
+    std::atomic<size_t> count = 0U;
+
+    {
+        thread_pool pool(4);
+        EXPECT_TRUE(pool.get_thread_count() == 4);
+
+        for (int i = 0; i < 100; i++) {
+            pool.submit([&]() {
+                // Nested tasks go to the worker's own queue
+                for (int j = 0; j < 10; j++)
+                    pool.submit([&]() { count++; });
+
+                count++;
+            });
+        }
+
+        pool.wait();
+        EXPECT_TRUE(count == 1100);
+
+        pool.submit([&]() { count++; });
+    }
+
+    EXPECT_TRUE(count == 1101);
+}
+
+TEST(job, thread_pool_runs_external_tasks_in_order) {
+    std::vector<int> order;
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+
+    {
+        thread_pool pool(1);
+
+        // Hold the worker until everything is queued
+        pool.submit([opened]() { opened.wait(); });
+
+        for (int i = 0; i < 16; i++)
+            pool.submit([&order, i]() { order.push_back(i); });
+
+        gate.set_value();
+        pool.wait();
+    }
+
+    ASSERT_TRUE(order.size() == 16);
+    for (int i = 0; i < 16; i++)
+        EXPECT_TRUE(order[i] == i);
+}
+
+TEST(job, directory_hash) {
+    auto dir = std::filesystem::temp_directory_path() / "libcrypt_test_job_hash";
+    std::filesystem::remove_all(dir);
+
+    std::vector<std::filesystem::path> paths = { dir / "a.bin", dir / "sub/b.bin", dir / "sub/deeper/c.bin", dir / "empty.bin" };
+    std::vector<size_t>                sizes = { 70000, 3, 1 << 20, 0 };
+
+    for (size_t i = 0; i < paths.size(); i++)
+        write_file(paths[i], make_buffer(sizes[i], (uint8_t)i));
+
+    crypt_job job;
+    job.set_operation(crypt_job::operation::hash);
+    job.set_thread_count(3);
+
+    EXPECT_TRUE(job.add_directory(dir));
+    EXPECT_TRUE(job.get_count() == paths.size());
+    EXPECT_FALSE(job.add_directory(dir / "missing"));
+
+    crypt_job::report report;
+    EXPECT_TRUE(job.run(report));
+    EXPECT_TRUE(report.files.size() == paths.size());
+    EXPECT_TRUE(report.failed == 0);
+    EXPECT_TRUE(report.total_size == 70000 + 3 + (1 << 20));
+
+    md5 md5;
+    for (const auto& file : report.files) {
+        auto buffer = read_file(file.input);
+
+        EXPECT_TRUE(file.result);
+        EXPECT_TRUE(file.size == buffer.size());
+
+        md5.update(buffer.data(), buffer.size());
+        EXPECT_TRUE(file.hash == md5.finalize());
+    }
+
+    job.add_file(dir / "missing.bin");
+    EXPECT_FALSE(job.run(report));
+    EXPECT_TRUE(report.failed == 1);
+    EXPECT_FALSE(report.files.back().result);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(job, directory_encrypt_decrypt) {
+    auto dir    = std::filesystem::temp_directory_path() / "libcrypt_test_job_crypt";
+    auto output = std::filesystem::temp_directory_path() / "libcrypt_test_job_crypt_out";
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove_all(output);
+
+    std::vector<std::filesystem::path> paths = { "a.bin", "sub/b.bin", "sub/c.bin" };
+    std::vector<size_t>                sizes = { 5000, 300000, 17 };
+
+    for (size_t i = 0; i < paths.size(); i++)
+        write_file(dir / paths[i], make_buffer(sizes[i], (uint8_t)i));
+
+    crypt_job job;
+    job.set_operation(crypt_job::operation::encrypt);
+    job.set_key("testing");
+    job.set_iv(91);
+
+    crypt_job::report report;
+    EXPECT_TRUE(job.add_directory(dir, output));
+    EXPECT_TRUE(job.run(report));
+
+    for (size_t i = 0; i < paths.size(); i++) {
+        rc4 rc4;
+        rc4.set_key("testing");
+        rc4.set_iv(91);
+
+        auto expected = make_buffer(sizes[i], (uint8_t)i);
+        rc4.encrypt_buffer(expected);
+
+        EXPECT_TRUE(read_file(output / paths[i]) == expected);
+    }
+
+    // Decrypt in place
+    job.clear();
+    job.set_operation(crypt_job::operation::decrypt);
+
+    EXPECT_TRUE(job.add_directory(output));
+    EXPECT_TRUE(job.run(report));
+
+    for (size_t i = 0; i < paths.size(); i++)
+        EXPECT_TRUE(read_file(output / paths[i]) == make_buffer(sizes[i], (uint8_t)i));
+
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove_all(output);
+}
+
+TEST(job, file_queue_hash_encrypt) {
+    auto dir = std::filesystem::temp_directory_path() / "libcrypt_test_file_queue";
+    std::filesystem::remove_all(dir);
+
+    std::vector<size_t> sizes = { 100000, 0, 4096, 12345, 7 };
+    for (size_t i = 0; i < sizes.size(); i++)
+        write_file(dir / std::to_string(i), make_buffer(sizes[i], (uint8_t)i));
+
+    auto schedule = rc4_key_schedule::get("testing", 91);
+
+    file_queue queue;
+    queue.set_queue_depth(4);
+    queue.set_block_size(4096);
+
+    std::vector<std::array<uint8_t, 16>> hashes(sizes.size());
+    size_t callbacks = 0U;
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        queue.hash_file_async(dir / std::to_string(i), [&, i](const auto&, const crypt_result& result, const auto& hash) {
+            EXPECT_TRUE(result);
+            hashes[i] = hash;
+            callbacks++;
+        });
+
+        queue.encrypt_file_async(schedule, dir / std::to_string(i), dir / "out" / std::to_string(i), [&](const auto&, const crypt_result& result) {
+            EXPECT_TRUE(result);
+            callbacks++;
+        });
+    }
+
+    queue.encrypt_file_async(schedule, dir / "missing", "", [&](const auto&, const crypt_result& result) {
+        EXPECT_FALSE(result);
+        callbacks++;
+    });
+
+    EXPECT_FALSE(queue.run());
+    EXPECT_TRUE(callbacks == sizes.size() * 2 + 1);
+
+    // CI sets this to make sure the io_uring build doesn't quietly fall back
+    if (const char* backend = std::getenv("LIBCRYPT_TEST_IO_BACKEND")) {
+        EXPECT_STREQ(queue.get_backend(), backend);
+    }
+
+    md5 md5;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        auto buffer = make_buffer(sizes[i], (uint8_t)i);
+
+        md5.update(buffer.data(), buffer.size());
+        EXPECT_TRUE(hashes[i] == md5.finalize());
+
+        rc4 rc4;
+        rc4.set_key("testing");
+        rc4.set_iv(91);
+        rc4.encrypt_buffer(buffer);
+
+        EXPECT_TRUE(read_file(dir / "out" / std::to_string(i)) == buffer);
+    }
+
+    // Decrypt in place
+    for (size_t i = 0; i < sizes.size(); i++)
+        queue.decrypt_file_async(schedule, dir / "out" / std::to_string(i), "", nullptr);
+
+    EXPECT_TRUE(queue.run());
+
+    for (size_t i = 0; i < sizes.size(); i++)
+        EXPECT_TRUE(read_file(dir / "out" / std::to_string(i)) == make_buffer(sizes[i], (uint8_t)i));
+
+    std::filesystem::remove_all(dir);
+}
\ No newline at end of file
@@ -1,8 +1,36 @@
 #include <libcrypt.hpp>
 #include <gtest/gtest.h>
 
+#include <deque>
+#include <fstream>
+
 using namespace libcrypt;
 
+// Resumes posted coroutines one at a time from run()
+struct queue_executor : public executor {
+    std::deque<std::coroutine_handle<>> handles;
+
+    void post(std::coroutine_handle<> handle) override {
+        handles.push_back(handle);
+    }
+
+    size_t run() {
+        size_t count = 0U;
+
+        for (; !handles.empty(); count++) {
+            auto handle = handles.front();
+            handles.pop_front();
+            handle.resume();
+        }
+
+        return count;
+    }
+};
+
+static task<crypt_result> await_task(task<crypt_result>& inner) {
+    co_return co_await inner;
+}
+
 TEST(md5, hashing) {
     const char plaintext[5] = { 'd', 'v', 's', 'k', 'u' };
     md5 md5;
@@ -35,4 +63,460 @@ TEST(md5, hash_to_string) {
     auto hash_str = md5.to_string(hash);
 
     EXPECT_TRUE(hash_str == "e7783f212ecb54995a79892932abb5a4");
+}
+
+TEST(md5, compile_time_hashing_matches_compute) {
+    constexpr auto hash     = md5_ct("dvsku");
+    constexpr auto hash_str = md5_ct_to_string(hash);
+
+    static_assert(std::string_view(hash_str.data()) == "e7783f212ecb54995a79892932abb5a4");
+    static_assert(std::string_view(md5_ct_to_string(md5_ct("")).data()) == "d41d8cd98f00b204e9800998ecf8427e");
+
+    md5 md5;
+
+    for (size_t size : { 1, 55, 56, 63, 64, 65, 119, 120, 300 }) {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; i++)
+            data[i] = (char)(i * 13 + 1);
+
+        auto expected = md5.compute(data.data(), data.size());
+
+        EXPECT_TRUE(md5_ct(data) == expected);
+        EXPECT_EQ(std::string(md5_ct_to_string(expected).data()), md5.to_string(expected));
+    }
+}
+
+TEST(md5, incremental_hashing) {
+    const std::string plaintext = "The quick brown fox jumps over the lazy dog";
+    md5 md5;
+
+    for (size_t split = 0; split <= plaintext.size(); split++) {
+        md5.update(plaintext.data(), split);
+        md5.update(plaintext.data() + split, plaintext.size() - split);
+
+        EXPECT_TRUE(md5.to_string(md5.finalize()) == "9e107d9d372bb6826bd81d3542a419d6");
+    }
+
+    EXPECT_TRUE(md5.to_string(md5.finalize()) == "d41d8cd98f00b204e9800998ecf8427e");
+}
+
+TEST(md5, incremental_hashing_matches_compute) {
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 13 + 1);
+
+    md5 md5;
+    auto expected = md5.compute(data.data(), data.size());
+
+    for (size_t step : { 1, 7, 63, 64, 65, 200 }) {
+        for (size_t i = 0; i < data.size(); i += step)
+            md5.update(&data[i], std::min(step, data.size() - i));
+
+        EXPECT_TRUE(md5.finalize() == expected);
+    }
+}
+
+TEST(md5, segmented_hashing_matches_compute) {
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 13 + 1);
+
+    md5 md5;
+    auto expected = md5.compute(data.data(), data.size());
+
+    for (size_t step : { 1, 7, 63, 64, 65, 128, 200 }) {
+        std::vector<md5::segment_t> segments;
+        for (size_t i = 0; i < data.size(); i += step)
+            segments.emplace_back(&data[i], std::min(step, data.size() - i));
+
+        EXPECT_TRUE(md5.compute(segments) == expected);
+
+        md5.update(segments);
+        EXPECT_TRUE(md5.finalize() == expected);
+    }
+
+    std::vector<md5::segment_t> empty(3);
+    EXPECT_TRUE(md5.compute(empty) == md5.compute(nullptr, 0));
+}
+
+TEST(md5, midstate_fork_matches_compute) {
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 13 + 1);
+
+    md5 md5;
+
+    for (size_t split : { 0, 1, 63, 64, 65, 500 }) {
+        auto expected = md5.compute(data.data(), data.size());
+
+        md5.update(data.data(), split);
+        auto state = md5.get_state();
+
+        // Copy continues independently of the original
+        auto copy = md5;
+        copy.update(&data[split], data.size() - split);
+        EXPECT_TRUE(copy.finalize() == expected);
+
+        md5.update(data.data(), 10);
+        md5.set_state(state);
+        md5.update(&data[split], data.size() - split);
+        EXPECT_TRUE(md5.finalize() == expected);
+    }
+
+    std::vector<std::vector<uint8_t>> suffixes = { {}, { 1, 2, 3 }, std::vector<uint8_t>(200, 7) };
+    std::vector<md5::segment_t>       segments(suffixes.begin(), suffixes.end());
+
+    for (size_t prefix_size : { 0, 100 }) {
+        md5::segment_t prefix(data.data(), prefix_size);
+
+        auto digests = md5.compute_suffixes(prefix, segments);
+        ASSERT_EQ(digests.size(), suffixes.size());
+
+        for (size_t i = 0; i < suffixes.size(); i++) {
+            std::vector<uint8_t> message(data.begin(), data.begin() + prefix_size);
+            message.insert(message.end(), suffixes[i].begin(), suffixes[i].end());
+
+            EXPECT_TRUE(digests[i] == md5.compute(message.data(), message.size()));
+        }
+    }
+}
+
+TEST(md5, hmac_known_answers) {
+    struct vector {
+        std::string key;
+        std::string data;
+        std::string mac;
+    };
+
+    // RFC 2202 test cases 1-7
+    const vector vectors[] = {
+        { std::string(16, '\x0b'), "Hi There", "9294727a3638bb1c13f48ef8158bfc9d" },
+        { "Jefe", "what do ya want for nothing?", "750c783e6ab0b503eaa86e310a5db738" },
+        { std::string(16, '\xaa'), std::string(50, '\xdd'), "56be34521d144c88dbb8c733f0e8b3f6" },
+        { "\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19",
+            std::string(50, '\xcd'), "697eaf0aca3a3aea3a75164746ffaa79" },
+        { std::string(16, '\x0c'), "Test With Truncation", "56461ef2342edc00f9bab995690efd4c" },
+        { std::string(80, '\xaa'), "Test Using Larger Than Block-Size Key - Hash Key First",
+            "6b1ab7fe4bd7bf8f0b62e6ce61b9d0cd" },
+        { std::string(80, '\xaa'), "Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data",
+            "6f630fad67cda0ee1fb1f562db3aa53e" }
+    };
+
+    hmac_md5 hmac;
+    md5      md5;
+
+    for (const auto& test : vectors) {
+        hmac.set_key(test.key);
+
+        EXPECT_EQ(md5.to_string(hmac.compute(test.data.data(), test.data.size())), test.mac);
+
+        // Incremental and batch results match, one-shot MACs in between
+        // don't disturb the incremental one
+        for (size_t i = 0; i < test.data.size(); i++) {
+            hmac.update(&test.data[i], 1);
+
+            if (i == test.data.size() / 2)
+                EXPECT_EQ(md5.to_string(hmac.compute(test.data.data(), test.data.size())), test.mac);
+        }
+
+        EXPECT_EQ(md5.to_string(hmac.finalize()), test.mac);
+
+        std::vector<hmac_md5::segment_t> messages(3, hmac_md5::segment_t((const uint8_t*)test.data.data(), test.data.size()));
+
+        for (const auto& mac : hmac.compute_many(messages))
+            EXPECT_EQ(md5.to_string(mac), test.mac);
+    }
+
+    // Empty message
+    hmac.set_key("");
+    EXPECT_EQ(md5.to_string(hmac.compute(nullptr, 0)), "74e6f7298a9c2d168935f58c001bad88");
+}
+
+TEST(md5, batch_hashing_matches_compute) {
+    std::vector<std::vector<uint8_t>> data;
+    for (size_t size : { 5, 0, 55, 56, 63, 64, 65, 119, 120, 128, 1, 300, 1000, 3, 64, 4096, 17 }) {
+        std::vector<uint8_t> message(size);
+        for (size_t i = 0; i < size; i++)
+            message[i] = (uint8_t)(i * 31 + size);
+
+        data.push_back(message);
+    }
+
+    std::vector<std::span<const uint8_t>> messages(data.begin(), data.end());
+    md5 md5;
+
+    auto hashes = md5.compute_many(messages);
+    EXPECT_TRUE(hashes.size() == data.size());
+
+    for (size_t i = 0; i < data.size(); i++)
+        EXPECT_TRUE(hashes[i] == md5.compute(data[i].data(), data[i].size()));
+
+    const char plaintext[5] = { 'd', 'v', 's', 'k', 'u' };
+    std::span<const uint8_t> single((const uint8_t*)plaintext, 5);
+
+    EXPECT_TRUE(md5.to_string(md5.compute_many({ &single, 1 })[0]) == "e7783f212ecb54995a79892932abb5a4");
+}
+
+TEST(md5, batch_hashing_all_kernels_match) {
+    std::vector<std::vector<uint8_t>> data;
+    for (size_t size : { 0, 1, 55, 56, 64, 119, 120, 1000, 4096, 17, 3, 5, 63, 65, 128, 300, 2000, 9 }) {
+        std::vector<uint8_t> message(size);
+        for (size_t i = 0; i < size; i++)
+            message[i] = (uint8_t)(i * 13 + size);
+
+        data.push_back(message);
+    }
+
+    std::vector<std::span<const uint8_t>> messages(data.begin(), data.end());
+    md5 md5;
+
+    EXPECT_TRUE(kernels::set_active(kernel_isa::scalar));
+    auto expected = md5.compute_many(messages);
+
+    for (int isa = 0; isa <= (int)kernels::get_supported(); isa++) {
+        EXPECT_TRUE(kernels::set_active((kernel_isa)isa));
+        EXPECT_TRUE(kernels::get_active() == (kernel_isa)isa);
+
+        EXPECT_TRUE(md5.compute_many(messages) == expected);
+
+        for (size_t i = 0; i < data.size(); i++)
+            EXPECT_TRUE(md5.compute(data[i].data(), data[i].size()) == expected[i]);
+    }
+
+    EXPECT_FALSE(kernels::set_active((kernel_isa)((int)kernels::get_supported() + 1)));
+
+    kernels::reset_active();
+}
+
+TEST(md5, file_hashing) {
+    const std::string plaintext = "The quick brown fox jumps over the lazy dog";
+    auto path = std::filesystem::temp_directory_path() / "libcrypt_test_md5.txt";
+
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << plaintext;
+    }
+
+    md5 md5;
+    std::array<uint8_t, 16> hash{};
+
+    EXPECT_TRUE(md5.compute_file(path, hash));
+    EXPECT_TRUE(md5.to_string(hash) == "9e107d9d372bb6826bd81d3542a419d6");
+
+    std::filesystem::remove(path);
+    EXPECT_FALSE(md5.compute_file(path, hash));
+}
+
+TEST(md5, file_hashing_async) {
+    auto path = std::filesystem::temp_directory_path() / "libcrypt_test_md5_async.bin";
+
+    std::vector<uint8_t> data(3 * (1 << 20) + 100);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 31 + 7);
+
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write((const char*)data.data(), data.size());
+    }
+
+    queue_executor exec;
+    md5 md5;
+    std::array<uint8_t, 16> hash{};
+
+    auto task = md5.compute_file_async(exec, path, hash);
+    task.start();
+    EXPECT_FALSE(task.is_done());
+
+    EXPECT_TRUE(exec.run() == 4);
+    EXPECT_TRUE(task.is_done());
+    EXPECT_TRUE(task.get_result());
+
+    md5.update(data.data(), data.size());
+    EXPECT_TRUE(hash == md5.finalize());
+
+    std::filesystem::remove(path);
+
+    auto missing = md5.compute_file_async(exec, path, hash);
+    missing.start();
+    EXPECT_TRUE(missing.is_done());
+    EXPECT_FALSE(missing.get_result());
+}
+
+TEST(md5, file_hashing_async_await_started) {
+    auto path = std::filesystem::temp_directory_path() / "libcrypt_test_md5_await.bin";
+
+    std::vector<uint8_t> data(2 * (1 << 20) + 10, 0x5A);
+
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write((const char*)data.data(), data.size());
+    }
+
+    queue_executor exec;
+    md5 md5;
+    std::array<uint8_t, 16> hash{};
+
+    auto expected = md5.compute(data.data(), data.size());
+
+    // Awaited while suspended on the executor
+    auto inner = md5.compute_file_async(exec, path, hash);
+    inner.start();
+    EXPECT_FALSE(inner.is_done());
+
+    auto outer = await_task(inner);
+    outer.start();
+    EXPECT_FALSE(outer.is_done());
+
+    exec.run();
+    EXPECT_TRUE(outer.is_done());
+    EXPECT_TRUE(outer.get_result());
+    EXPECT_TRUE(hash == expected);
+
+    // Awaited after it already finished
+    hash = {};
+    auto finished = md5.compute_file_async(exec, path, hash);
+    finished.start();
+    exec.run();
+    EXPECT_TRUE(finished.is_done());
+
+    auto late = await_task(finished);
+    late.start();
+    EXPECT_TRUE(late.is_done());
+    EXPECT_TRUE(late.get_result());
+    EXPECT_TRUE(hash == expected);
+
+    std::filesystem::remove(path);
+}
+
+TEST(md5, empty_input_matches_everywhere) {
+    const std::string expected = "d41d8cd98f00b204e9800998ecf8427e";
+    auto path = std::filesystem::temp_directory_path() / "libcrypt_test_md5_empty.bin";
+
+    std::ofstream(path, std::ios::binary).close();
+
+    md5 md5;
+    md5::hash_t hash{};
+
+    EXPECT_EQ(md5.to_string(md5.compute(nullptr, 0)), expected);
+    EXPECT_EQ(md5.to_string(md5.finalize()), expected);
+    EXPECT_EQ(std::string(md5_ct_to_string(md5_ct("")).data()), expected);
+
+    std::vector<md5::segment_t> segments(3);
+    EXPECT_EQ(md5.to_string(md5.compute(segments)), expected);
+
+    auto suffixes = md5.compute_suffixes({}, segments);
+    for (const auto& suffix : suffixes)
+        EXPECT_EQ(md5.to_string(suffix), expected);
+
+    // Enough messages to fill every lane
+    std::vector<std::span<const uint8_t>> messages(9);
+    for (const auto& digest : md5.compute_many(messages))
+        EXPECT_EQ(md5.to_string(digest), expected);
+
+    EXPECT_TRUE(md5.compute_file(path, hash));
+    EXPECT_EQ(md5.to_string(hash), expected);
+
+    queue_executor exec;
+    hash = {};
+
+    auto task = md5.compute_file_async(exec, path, hash);
+    task.start();
+    exec.run();
+
+    EXPECT_TRUE(task.is_done() && task.get_result());
+    EXPECT_EQ(md5.to_string(hash), expected);
+
+    rc4 rc4;
+    rc4.set_key("testing");
+
+    std::vector<uint8_t> buffer;
+    EXPECT_TRUE(rc4.encrypt_buffer(buffer, hash));
+    EXPECT_EQ(md5.to_string(hash), expected);
+
+    std::filesystem::remove(path);
+}
+
+TEST(md5, digest_cache) {
+    auto dir        = std::filesystem::temp_directory_path() / "libcrypt_test_digest_cache";
+    auto cache_path = dir / "digests.bin";
+
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    // Files modified too recently aren't cached
+    auto write = [&](const std::filesystem::path& path, const std::string& data, int age) {
+        {
+            std::ofstream out(path, std::ios::binary);
+            out << data;
+        }
+
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() - std::chrono::minutes(age));
+    };
+
+    std::vector<std::filesystem::path> paths = { dir / "a.txt", dir / "b.txt", dir / "c.txt" };
+    write(paths[0], "The quick brown fox jumps over the lazy dog", 60);
+    write(paths[1], "", 60);
+    write(paths[2], "dvsku", 60);
+
+    md5 md5;
+    std::vector<md5_digest_cache::hash_t> expected(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+        EXPECT_TRUE(md5.compute_file(paths[i], expected[i]));
+
+    std::vector<md5_digest_cache::hash_t> hashes;
+
+    {
+        md5_digest_cache cache;
+        EXPECT_TRUE(cache.open(cache_path));
+
+        EXPECT_TRUE(cache.compute_files(paths, hashes, 2));
+        EXPECT_TRUE(hashes == expected);
+        EXPECT_TRUE(cache.get_statistics().misses == 3);
+        EXPECT_TRUE(cache.get_statistics().hits == 0);
+
+        md5_digest_cache::hash_t hash;
+        EXPECT_TRUE(cache.compute_file(paths[0], hash));
+        EXPECT_TRUE(hash == expected[0]);
+        EXPECT_TRUE(cache.get_statistics().hits == 1);
+        EXPECT_FALSE(cache.compute_file(dir / "missing.txt", hash));
+    }
+
+    md5_digest_cache cache;
+    EXPECT_TRUE(cache.open(cache_path));
+    EXPECT_TRUE(cache.get_count() == 3);
+
+    EXPECT_TRUE(cache.compute_files(paths, hashes));
+    EXPECT_TRUE(hashes == expected);
+    EXPECT_TRUE(cache.get_statistics().hits == 3);
+    EXPECT_TRUE(cache.get_statistics().misses == 0);
+
+    // Changed file is hashed again and the new record replaces the old one
+    write(paths[2], "dvsku dvsku", 30);
+    EXPECT_TRUE(md5.compute_file(paths[2], expected[2]));
+
+    EXPECT_TRUE(cache.compute_files(paths, hashes));
+    EXPECT_TRUE(hashes == expected);
+    EXPECT_TRUE(cache.get_statistics().misses == 1);
+
+    auto fresh = dir / "fresh.txt";
+    write(fresh, "fresh", 0);
+
+    md5_digest_cache::hash_t hash;
+    EXPECT_TRUE(cache.compute_file(fresh, hash));
+    EXPECT_TRUE(cache.get_count() == 3);
+
+    EXPECT_TRUE(cache.flush());
+    auto appended_size = std::filesystem::file_size(cache_path);
+
+    EXPECT_TRUE(cache.compact());
+    EXPECT_TRUE(std::filesystem::file_size(cache_path) < appended_size);
+
+    cache.close();
+    EXPECT_TRUE(cache.open(cache_path));
+    EXPECT_TRUE(cache.compute_files(paths, hashes));
+    EXPECT_TRUE(hashes == expected);
+    EXPECT_TRUE(cache.get_statistics().hits == 3);
+
+    cache.close();
+    std::filesystem::remove_all(dir);
 }
\ No newline at end of file
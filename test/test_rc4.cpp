@@ -1,8 +1,38 @@
 #include <libcrypt.hpp>
 #include <gtest/gtest.h>
 
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
 using namespace libcrypt;
 
+// Resumes posted coroutines one at a time from run()
+struct queue_executor : public executor {
+    std::deque<std::coroutine_handle<>> handles;
+
+    void post(std::coroutine_handle<> handle) override {
+        handles.push_back(handle);
+    }
+
+    size_t run() {
+        size_t count = 0U;
+
+        for (; !handles.empty(); count++) {
+            auto handle = handles.front();
+            handles.pop_front();
+            handle.resume();
+        }
+
+        return count;
+    }
+};
+
+static task<crypt_result> decrypt_in_place(executor& exec, rc4& rc4, std::filesystem::path path) {
+    co_return co_await rc4.decrypt_file_async(exec, path);
+}
+
 static bool compare_buffers(const std::vector<uint8_t>& b1, const std::vector<uint8_t>& b2) {
     if (b1.size() != b2.size())
         return false;
@@ -10,6 +40,16 @@ static bool compare_buffers(const std::vector<uint8_t>& b1, const std::vector<ui
     return std::equal(b1.begin(), b1.end(), b2.begin());
 }
 
+static std::vector<uint8_t> read_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static void write_file(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+    std::ofstream out(path, std::ios::binary);
+    out.write((const char*)data.data(), data.size());
+}
+
 TEST(rc4, key_setting) {
     rc4 rc4;
 
@@ -130,3 +170,962 @@ TEST(rc4, buffer_encrypt_decrypt_stream_ok) {
 
     EXPECT_TRUE(compare_buffers(v1, v2));
 }
+
+
+TEST(rc4, stream_checkpoints_ok) {
+    rc4 rc4;
+
+    std::vector<uint8_t> v1(10000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 7);
+
+    std::vector<uint8_t> v2 = v1;
+
+    rc4.set_key("testing");
+    rc4.set_iv(91);
+    rc4.encrypt_buffer(v2);
+
+    rc4_checkpoints checkpoints;
+    EXPECT_TRUE(rc4.build_checkpoints(checkpoints, v2.size(), 1024));
+    EXPECT_TRUE(checkpoints.get_count() == 10);
+
+    auto path = std::filesystem::temp_directory_path() / "libcrypt_test_checkpoints.bin";
+    EXPECT_TRUE(checkpoints.save(path));
+
+    rc4_checkpoints loaded;
+    EXPECT_TRUE(loaded.load(path));
+    EXPECT_TRUE(loaded.get_count() == checkpoints.get_count());
+    EXPECT_TRUE(loaded.get_interval() == 1024);
+    std::filesystem::remove(path);
+
+    rc4.set_checkpoints(&loaded);
+
+    rc4.decrypt_stream(&v2[5000], 3000, 5000);
+    rc4.decrypt_stream(&v2[8000], 2000, 8000);
+    rc4.decrypt_stream(&v2[10],   4990, 10);
+    rc4.decrypt_stream(&v2[0],    10,   0);
+    rc4.reset();
+
+    EXPECT_TRUE(compare_buffers(v1, v2));
+}
+
+TEST(rc4, stream_interleaved_cursors_ok) {
+    std::vector<uint8_t> v1(30000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 11);
+
+    for (size_t cursors : { 1, 2, 4 }) {
+        rc4 rc4;
+        rc4.set_key("testing");
+        rc4.set_iv(17);
+        rc4.set_cursor_count(cursors);
+
+        std::vector<uint8_t> v2 = v1;
+        rc4.encrypt_buffer(v2);
+
+        // Three interleaved sequential readers
+        for (size_t i = 0; i < 10000; i += 500) {
+            rc4.decrypt_stream(&v2[i],         500, i);
+            rc4.decrypt_stream(&v2[20000 + i], 500, 20000 + i);
+            rc4.decrypt_stream(&v2[10000 + i], 500, 10000 + i);
+        }
+
+        rc4.reset();
+
+        EXPECT_EQ(rc4.get_cursor_count(), cursors);
+        EXPECT_TRUE(compare_buffers(v1, v2));
+    }
+}
+
+TEST(rc4, stream_checkpoints_wrong_key_ignored) {
+    rc4 rc4;
+
+    std::vector<uint8_t> v1(4096, 0x5A);
+    std::vector<uint8_t> v2 = v1;
+
+    rc4_checkpoints checkpoints;
+    rc4.set_key("other");
+    rc4.build_checkpoints(checkpoints, v2.size(), 256);
+
+    rc4.set_key("testing");
+    rc4.encrypt_buffer(v2);
+
+    rc4.set_checkpoints(&checkpoints);
+    rc4.decrypt_stream(&v2[1000], 3096, 1000);
+    rc4.decrypt_stream(&v2[0],    1000, 0);
+    rc4.reset();
+
+    EXPECT_TRUE(compare_buffers(v1, v2));
+}
+
+TEST(rc4, file_encrypt_decrypt_chunked_ok) {
+    rc4 rc4;
+
+    std::vector<uint8_t> v1(15000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 11);
+
+    auto dir    = std::filesystem::temp_directory_path() / "libcrypt_test_chunked";
+    auto input  = dir / "input.bin";
+    auto output = dir / "output" / "output.bin";
+
+    std::filesystem::create_directories(dir);
+    write_file(input, v1);
+
+    rc4.set_key("testing");
+    rc4.set_iv(91);
+    rc4.set_chunk_size(4096);
+
+    std::vector<uint8_t> expected = v1;
+    rc4.encrypt_buffer(expected);
+
+    EXPECT_TRUE(rc4.encrypt_file(input, output));
+    EXPECT_TRUE(compare_buffers(expected, read_file(output)));
+
+    std::vector<uint8_t> v2;
+    EXPECT_TRUE(rc4.decrypt_file(output, v2));
+    EXPECT_TRUE(compare_buffers(v1, v2));
+
+    EXPECT_TRUE(rc4.encrypt_file(input));
+    EXPECT_TRUE(compare_buffers(expected, read_file(input)));
+
+    EXPECT_TRUE(rc4.decrypt_file(input, input));
+    EXPECT_TRUE(compare_buffers(v1, read_file(input)));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(rc4, file_decrypt_to_buffer_ok) {
+    rc4 rc4;
+
+    std::vector<uint8_t> v1(5000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 3);
+
+    auto path = std::filesystem::temp_directory_path() / "libcrypt_test_mapped.bin";
+    write_file(path, v1);
+
+    rc4.set_key("testing");
+    rc4.set_iv(91);
+
+    std::vector<uint8_t> expected = v1;
+    rc4.encrypt_buffer(expected);
+
+    std::vector<uint8_t> v2;
+    EXPECT_TRUE(rc4.encrypt_file(path, v2));
+    EXPECT_TRUE(compare_buffers(expected, v2));
+    EXPECT_TRUE(compare_buffers(v1, read_file(path)));
+
+    EXPECT_TRUE(rc4.encrypt_file(path));
+    EXPECT_TRUE(rc4.decrypt_file(path, v2));
+    EXPECT_TRUE(compare_buffers(v1, v2));
+
+    write_file(path, {});
+    EXPECT_TRUE(rc4.decrypt_file(path, v2));
+    EXPECT_TRUE(v2.empty());
+    EXPECT_TRUE(rc4.encrypt_file(path));
+
+    std::filesystem::remove(path);
+}
+
+TEST(rc4, key_schedule_cursor_ok) {
+    rc4 rc4;
+
+    std::vector<uint8_t> v1(3000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 5);
+
+    std::vector<uint8_t> expected = v1;
+
+    rc4.set_key("0x6476736B75");
+    rc4.set_iv(91);
+    rc4.encrypt_buffer(expected);
+
+    auto schedule = rc4_key_schedule::get("0x6476736B75", 91);
+    EXPECT_TRUE(schedule == rc4_key_schedule::get("0x6476736B75", 91));
+    EXPECT_TRUE(schedule != rc4_key_schedule::get("0x6476736B75", 92));
+    EXPECT_TRUE(schedule->get_key() == "dvsku");
+
+    rc4_cursor cursor(schedule);
+    std::vector<uint8_t> v2 = v1;
+
+    cursor.crypt(&v2[0], 1000);
+    cursor.crypt(&v2[1000], 2000);
+    EXPECT_TRUE(cursor.get_offset() == 3000);
+    EXPECT_TRUE(compare_buffers(expected, v2));
+
+    rc4_checkpoints checkpoints;
+    rc4.build_checkpoints(checkpoints, v2.size(), 512);
+
+    rc4_cursor copy = cursor;
+    copy.seek(1500, &checkpoints);
+    copy.crypt(&v2[1500], 1500);
+    cursor.seek(0);
+    cursor.crypt(&v2[0], 1500);
+    EXPECT_TRUE(compare_buffers(v1, v2));
+
+    libcrypt::rc4 other;
+    other.set_key_schedule(*schedule);
+    EXPECT_TRUE(other.get_key() == "dvsku");
+    EXPECT_TRUE(other.get_iv() == 91);
+
+    other.decrypt_buffer(expected);
+    EXPECT_TRUE(compare_buffers(v1, expected));
+
+    rc4_key_schedule::clear_cache();
+    EXPECT_TRUE(schedule != rc4_key_schedule::get("0x6476736B75", 91));
+}
+
+TEST(rc4, key_schedule_mid_stream_ok) {
+    std::vector<uint8_t> v1(4000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 7);
+
+    auto schedule = rc4_key_schedule::get("testing", 3);
+
+    rc4 expected;
+    expected.set_key_schedule(*schedule);
+
+    std::vector<uint8_t> v2 = v1;
+    expected.encrypt_buffer(v2);
+
+    // Leave a stream position and parked cursors under another key
+    rc4 rc4;
+    rc4.set_key("dvsku");
+
+    std::vector<uint8_t> v3 = v1;
+    rc4.encrypt_stream(&v3[0],    1000, 0);
+    rc4.encrypt_stream(&v3[3000], 1000, 3000);
+    rc4.encrypt_stream(&v3[1000], 1000, 1000);
+
+    rc4.set_key_schedule(*schedule);
+
+    v3 = v1;
+    rc4.encrypt_stream(&v3[2000], 2000, 2000);
+    rc4.encrypt_stream(&v3[0],    2000, 0);
+    rc4.reset();
+
+    EXPECT_TRUE(compare_buffers(v2, v3));
+}
+
+TEST(rc4, buffer_encrypt_known_answer) {
+    rc4 rc4;
+    md5 md5;
+
+    std::vector<uint8_t> v1(5000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 7 + 1);
+
+    rc4.set_key("testing");
+    rc4.set_iv(91);
+    rc4.encrypt_buffer(v1);
+
+    EXPECT_TRUE(md5.to_string(md5.compute(v1.data(), v1.size())) == "7e2931e55ee5966213e996d932cd3278");
+
+    std::vector<uint8_t> v2(5000);
+    for (size_t i = 0; i < v2.size(); i++)
+        v2[i] = (uint8_t)(i * 7 + 1);
+
+    for (size_t offset = 0, step = 1; offset < v2.size(); offset += step, step = step * 3 + 1)
+        rc4.encrypt_stream(&v2[offset], std::min(step, v2.size() - offset), offset);
+
+    rc4.reset();
+
+    EXPECT_TRUE(compare_buffers(v1, v2));
+}
+
+TEST(rc4, buffer_encrypt_all_kernels_match) {
+    md5 md5;
+
+    for (int isa = 0; isa <= (int)kernels::get_supported(); isa++) {
+        EXPECT_TRUE(kernels::set_active((kernel_isa)isa));
+
+        rc4 rc4;
+
+        std::vector<uint8_t> v1(5000);
+        for (size_t i = 0; i < v1.size(); i++)
+            v1[i] = (uint8_t)(i * 7 + 1);
+
+        rc4.set_key("testing");
+        rc4.set_iv(91);
+        rc4.encrypt_buffer(v1);
+
+        EXPECT_TRUE(md5.to_string(md5.compute(v1.data(), v1.size())) == "7e2931e55ee5966213e996d932cd3278");
+    }
+
+    kernels::reset_active();
+}
+
+template<typename T>
+static bool static_matches_rc4(const std::string& key, uint8_t iv) {
+    std::vector<uint8_t> v1(5000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 7 + 1);
+
+    std::vector<uint8_t> v2 = v1;
+
+    rc4 dynamic;
+    dynamic.set_key(key);
+    dynamic.set_iv(iv);
+    dynamic.encrypt_buffer(v1);
+
+    T fixed;
+    fixed.encrypt_buffer(v2);
+
+    return compare_buffers(v1, v2) && fixed.get_key() == dynamic.get_key();
+}
+
+TEST(rc4, static_key_matches_rc4) {
+    using namespace libcrypt::literals;
+
+    EXPECT_TRUE((static_matches_rc4<rc4_static<"testing">>("testing", 0)));
+    EXPECT_TRUE((static_matches_rc4<rc4_static<"testing"_k, 91>>("testing", 91)));
+    EXPECT_TRUE((static_matches_rc4<rc4_static<"0x6B6579", 255>>("0x6B6579", 255)));
+    EXPECT_TRUE((static_matches_rc4<rc4_static<"0xABC", 3>>("0xABC", 3)));
+
+    static constexpr char long_key[] =
+        "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+        "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+        "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+        "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef!";
+
+    EXPECT_TRUE((static_matches_rc4<rc4_static<long_key, 7>>(long_key, 7)));
+
+    // Box is a compile time constant
+    static_assert(rc4_static<"testing", 91>::box.size() == 256);
+
+    rc4_key_schedule schedule("testing", 91);
+    EXPECT_TRUE(std::equal(rc4_static<"testing", 91>::box.begin(), rc4_static<"testing", 91>::box.end(), schedule.get_box()));
+}
+
+TEST(rc4, batch_encrypt_ok) {
+    rc4 rc4;
+
+    std::vector<std::vector<uint8_t>> buffers;
+    std::vector<std::vector<uint8_t>> expected;
+    std::vector<rc4_batch::record>    records;
+
+    const char* keys[3] = { "testing", "dvsku", "0x6476736B75" };
+    auto schedule       = rc4_key_schedule::get("testing2", 7);
+
+    for (size_t i = 0; i < 11; i++) {
+        std::vector<uint8_t> buffer(i * 97 % 500);
+        for (size_t j = 0; j < buffer.size(); j++)
+            buffer[j] = (uint8_t)(i + j);
+
+        buffers.push_back(buffer);
+
+        rc4_batch::record record;
+        record.key = keys[i % 3];
+        record.iv  = (uint8_t)(i * 40);
+
+        if (i == 6) {
+            record.schedule = schedule.get();
+            rc4.set_key_schedule(*schedule);
+        }
+        else {
+            rc4.set_key(keys[i % 3]);
+            rc4.set_iv(record.iv);
+        }
+
+        rc4.encrypt_buffer(buffer);
+        expected.push_back(buffer);
+
+        records.push_back(record);
+    }
+
+    for (size_t i = 0; i < records.size(); i++) {
+        records[i].ptr  = buffers[i].data();
+        records[i].size = buffers[i].size();
+    }
+
+    EXPECT_TRUE(rc4_batch::crypt(records));
+
+    for (size_t i = 0; i < buffers.size(); i++)
+        EXPECT_TRUE(compare_buffers(expected[i], buffers[i]));
+}
+
+TEST(rc4, batch_empty_key_ok) {
+    rc4 rc4;
+
+    std::vector<std::vector<uint8_t>> buffers;
+    std::vector<std::vector<uint8_t>> expected;
+    std::vector<rc4_batch::record>    records;
+
+    // "0x" parses to an empty key
+    const char* keys[3] = { "", "0x", "testing" };
+
+    for (size_t i = 0; i < 9; i++) {
+        std::vector<uint8_t> buffer(300 + i);
+        for (size_t j = 0; j < buffer.size(); j++)
+            buffer[j] = (uint8_t)(i * 3 + j);
+
+        buffers.push_back(buffer);
+
+        rc4_batch::record record;
+        record.key = keys[i % 3];
+        record.iv  = (uint8_t)(i * 29);
+
+        rc4.set_key(keys[i % 3]);
+        rc4.set_iv(record.iv);
+        rc4.encrypt_buffer(buffer);
+        expected.push_back(buffer);
+
+        records.push_back(record);
+    }
+
+    for (size_t i = 0; i < records.size(); i++) {
+        records[i].ptr  = buffers[i].data();
+        records[i].size = buffers[i].size();
+    }
+
+    EXPECT_TRUE(rc4_batch::crypt(records));
+
+    for (size_t i = 0; i < buffers.size(); i++)
+        EXPECT_TRUE(compare_buffers(expected[i], buffers[i]));
+}
+
+TEST(rc4, out_of_place_encrypt_decrypt_ok) {
+    rc4 rc4;
+
+    std::vector<uint8_t> v1(10000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 5 + 3);
+
+    const std::vector<uint8_t> source = v1;
+    std::vector<uint8_t>       expected = v1;
+
+    rc4.set_key("testing");
+    rc4.set_iv(91);
+    rc4.encrypt_buffer(expected);
+
+    std::vector<uint8_t> out;
+    EXPECT_TRUE(rc4.encrypt_buffer(source, out));
+    EXPECT_TRUE(compare_buffers(out, expected));
+
+    std::vector<uint8_t> decrypted(out.size());
+    EXPECT_TRUE(rc4.decrypt_buffer(out.data(), decrypted.data(), out.size()));
+    EXPECT_TRUE(compare_buffers(decrypted, source));
+
+    std::vector<uint8_t> streamed(source.size());
+    rc4.encrypt_stream(&source[5000], &streamed[5000], 5000, 5000);
+    rc4.encrypt_stream(&source[0],    &streamed[0],    5000, 0);
+    rc4.reset();
+
+    EXPECT_TRUE(compare_buffers(streamed, expected));
+
+    auto schedule = rc4_key_schedule::get("testing", 91);
+
+    rc4_cursor cursor(schedule);
+    std::vector<uint8_t> cursored(source.size());
+    EXPECT_TRUE(cursor.crypt(source.data(), cursored.data(), source.size()));
+    EXPECT_TRUE(compare_buffers(cursored, expected));
+
+    rc4_keystream_cache cache;
+    EXPECT_TRUE(cache.build(schedule, 4000));
+
+    std::vector<uint8_t> cached(source.size());
+    EXPECT_TRUE(cache.crypt(source.data(), cached.data(), source.size(), 0));
+    EXPECT_TRUE(compare_buffers(cached, expected));
+    EXPECT_TRUE(compare_buffers(source, v1));
+}
+
+TEST(rc4, segmented_encrypt_decrypt_ok) {
+    rc4 rc4;
+
+    std::vector<uint8_t> v1(10000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 5 + 3);
+
+    std::vector<uint8_t> expected = v1;
+
+    rc4.set_key("testing");
+    rc4.set_iv(91);
+    rc4.encrypt_buffer(expected);
+
+    for (size_t step : { 1, 63, 64, 300, 4096, 5000 }) {
+        std::vector<uint8_t> v2 = v1;
+
+        std::vector<rc4::segment_t> segments;
+        for (size_t i = 0; i < v2.size(); i += step)
+            segments.emplace_back(&v2[i], std::min(step, v2.size() - i));
+
+        EXPECT_TRUE(rc4.encrypt_buffer(segments));
+        EXPECT_TRUE(compare_buffers(v2, expected));
+
+        // Second half first, then the first half as one stream range
+        size_t half   = segments.size() / 2;
+        size_t offset = half * step;
+
+        EXPECT_TRUE(rc4.decrypt_stream(std::span(segments).subspan(half), offset));
+        EXPECT_TRUE(rc4.decrypt_stream(std::span(segments).first(half), 0));
+        rc4.reset();
+
+        EXPECT_TRUE(compare_buffers(v2, v1));
+    }
+}
+
+TEST(rc4, keystream_cache_ok) {
+    rc4 rc4;
+
+    std::vector<uint8_t> v1(8000);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 9);
+
+    std::vector<uint8_t> expected = v1;
+
+    rc4.set_key("testing");
+    rc4.set_iv(91);
+    rc4.encrypt_buffer(expected);
+
+    auto schedule = rc4_key_schedule::get("testing", 91);
+
+    rc4_keystream_cache cache;
+    EXPECT_TRUE(cache.build(schedule, 5000));
+    EXPECT_TRUE(cache.get_length() == 5000);
+
+    auto path = std::filesystem::temp_directory_path() / "libcrypt_test_keystream.bin";
+    EXPECT_TRUE(cache.save(path));
+
+    rc4_keystream_cache loaded;
+    EXPECT_FALSE(loaded.load(rc4_key_schedule::get("testing", 92), path));
+    EXPECT_TRUE(loaded.load(schedule, path));
+    EXPECT_TRUE(loaded.get_length() == 5000);
+
+    for (auto* current : { &cache, &loaded }) {
+        std::vector<uint8_t> v2 = v1;
+
+        current->crypt(&v2[6000], 2000, 6000);
+        current->crypt(&v2[0],    1000, 0);
+        current->crypt(&v2[1000], 5000, 1000);
+
+        EXPECT_TRUE(compare_buffers(expected, v2));
+    }
+
+    loaded.clear();
+    std::filesystem::remove(path);
+}
+
+TEST(rc4, keystream_cache_threads_tail_ok) {
+    auto schedule = rc4_key_schedule::get("testing", 91);
+
+    std::vector<uint8_t> v1(5 << 20);
+    for (size_t i = 0; i < v1.size(); i++)
+        v1[i] = (uint8_t)(i * 9);
+
+    std::vector<uint8_t> expected(v1.size());
+    rc4_cursor cursor(schedule);
+    cursor.crypt(v1.data(), expected.data(), v1.size());
+
+    rc4_keystream_cache cache;
+    cache.set_thread_count(4);
+    EXPECT_TRUE(cache.build(schedule, 4 << 20));
+
+    // Pooled prefix twice, then tail ranges forwards and backwards
+    for (int i = 0; i < 2; i++) {
+        std::vector<uint8_t> v2(v1.size());
+
+        EXPECT_TRUE(cache.crypt(&v1[0], &v2[0], 4 << 20, 0));
+        EXPECT_TRUE(cache.crypt(&v1[4600000], &v2[4600000], v1.size() - 4600000, 4600000));
+        EXPECT_TRUE(cache.crypt(&v1[4300000], &v2[4300000], 300000, 4300000));
+        EXPECT_TRUE(cache.crypt(&v1[4 << 20], &v2[4 << 20], 4300000 - (4 << 20), 4 << 20));
+
+        EXPECT_TRUE(compare_buffers(v2, expected));
+    }
+}
+
+TEST(rc4, file_encrypt_decrypt_async_ok) {
+    auto input  = std::filesystem::temp_directory_path() / "libcrypt_test_rc4_async.bin";
+    auto output = std::filesystem::temp_directory_path() / "libcrypt_test_rc4_async_out.bin";
+
+    std::vector<uint8_t> data(300000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 7 + 1);
+
+    write_file(input, data);
+
+    queue_executor exec;
+    rc4 rc4;
+
+    rc4.set_key("testing");
+    rc4.set_iv(91);
+    rc4.set_chunk_size(4096);
+
+    auto encrypt = rc4.encrypt_file_async(exec, input, output);
+    encrypt.start();
+    EXPECT_FALSE(encrypt.is_done());
+
+    // One resume per chunk
+    EXPECT_TRUE(exec.run() == (data.size() + 4095) / 4096);
+    EXPECT_TRUE(encrypt.is_done());
+    EXPECT_TRUE(encrypt.get_result());
+
+    auto expected = data;
+    rc4.encrypt_buffer(expected);
+
+    EXPECT_TRUE(compare_buffers(read_file(output), expected));
+
+    auto decrypt = decrypt_in_place(exec, rc4, output);
+    decrypt.start();
+    exec.run();
+
+    EXPECT_TRUE(decrypt.is_done());
+    EXPECT_TRUE(decrypt.get_result());
+    EXPECT_TRUE(compare_buffers(read_file(output), data));
+
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+}
+
+TEST(rc4, streambuf_encrypt_decrypt_ok) {
+    std::vector<uint8_t> data(100000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 7 + 1);
+
+    rc4 rc4;
+    rc4.set_key("testing");
+    rc4.set_iv(91);
+
+    auto expected = data;
+    rc4.encrypt_buffer(expected);
+
+    std::stringstream encrypted;
+
+    {
+        rc4_ostream out(encrypted, rc4, 4096);
+        out.write((const char*)data.data(), 1000);
+        out.put((char)data[1000]);
+        out.write((const char*)data.data() + 1001, data.size() - 1001);
+    }
+
+    std::string encrypted_data = encrypted.str();
+    EXPECT_TRUE(compare_buffers(std::vector<uint8_t>(encrypted_data.begin(), encrypted_data.end()), expected));
+
+    rc4_checkpoints checkpoints;
+    EXPECT_TRUE(rc4.build_checkpoints(checkpoints, data.size(), 8192));
+    rc4.set_checkpoints(&checkpoints);
+
+    rc4_istream in(encrypted, rc4, 4096);
+
+    std::vector<uint8_t> decrypted(data.size());
+    EXPECT_TRUE(in.read((char*)decrypted.data(), decrypted.size()));
+    EXPECT_TRUE(compare_buffers(decrypted, data));
+
+    // Seeks decrypt from the new offset
+    for (size_t offset : { 50000, 10, 99990, 4096, 70001 }) {
+        uint8_t value[10]{};
+
+        EXPECT_TRUE(in.seekg(offset));
+        EXPECT_TRUE(in.tellg() == (std::streamoff)offset);
+        EXPECT_TRUE(in.read((char*)value, sizeof(value)));
+        EXPECT_TRUE(std::equal(value, value + sizeof(value), data.begin() + offset));
+        EXPECT_TRUE(in.tellg() == (std::streamoff)(offset + sizeof(value)));
+    }
+
+    rc4.set_checkpoints(nullptr);
+}
+
+TEST(rc4, streambuf_read_write_ok) {
+    std::vector<uint8_t> data(20000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 13 + 5);
+
+    rc4 rc4;
+    rc4.set_key("testing");
+
+    std::stringstream inner;
+    rc4_streambuf buffer(inner.rdbuf(), rc4, 1024);
+    std::iostream stream(&buffer);
+
+    stream.write((const char*)data.data(), data.size());
+    stream.seekg(0);
+
+    // Read part, then overwrite from the read position
+    std::vector<uint8_t> part(3000);
+    EXPECT_TRUE(stream.read((char*)part.data(), part.size()));
+    EXPECT_TRUE(std::equal(part.begin(), part.end(), data.begin()));
+
+    for (size_t i = 3000; i < 4000; i++)
+        data[i] = (uint8_t)~data[i];
+
+    stream.seekp(3000);
+    stream.write((const char*)data.data() + 3000, 1000);
+    stream.flush();
+
+    std::vector<uint8_t> decrypted(data.size());
+    stream.seekg(0);
+    EXPECT_TRUE(stream.read((char*)decrypted.data(), decrypted.size()));
+    EXPECT_TRUE(compare_buffers(decrypted, data));
+
+    // Inner stream holds ciphertext
+    std::string encrypted_data = inner.str();
+    std::vector<uint8_t> encrypted(encrypted_data.begin(), encrypted_data.end());
+
+    libcrypt::rc4 other;
+    other.set_key("testing");
+    other.decrypt_buffer(encrypted);
+
+    EXPECT_TRUE(compare_buffers(encrypted, data));
+}
+
+TEST(rc4, streambuf_after_header_ok) {
+    std::vector<uint8_t> data(20000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 11 + 3);
+
+    rc4 rc4;
+    rc4.set_key("testing");
+
+    std::stringstream inner;
+    inner << "HEADER";
+
+    {
+        rc4_ostream out(inner, rc4, 1024);
+        out.write((const char*)data.data(), data.size());
+    }
+
+    auto expected = data;
+    rc4.encrypt_buffer(expected);
+
+    std::string encrypted_data = inner.str();
+    EXPECT_TRUE(encrypted_data.compare(0, 6, "HEADER") == 0);
+    EXPECT_TRUE(compare_buffers(std::vector<uint8_t>(encrypted_data.begin() + 6, encrypted_data.end()), expected));
+
+    char header[6]{};
+    inner.read(header, sizeof(header));
+
+    rc4_istream in(inner, rc4, 1024);
+
+    // Offsets are relative to the end of the header
+    for (size_t offset : { 15000, 0, 19990, 1024 }) {
+        uint8_t value[10]{};
+
+        EXPECT_TRUE(in.seekg(offset));
+        EXPECT_TRUE(in.tellg() == (std::streamoff)offset);
+        EXPECT_TRUE(in.read((char*)value, sizeof(value)));
+        EXPECT_TRUE(std::equal(value, value + sizeof(value), data.begin() + offset));
+    }
+
+    EXPECT_TRUE(in.seekg(-10, std::ios_base::end));
+    EXPECT_TRUE(in.tellg() == (std::streamoff)(data.size() - 10));
+}
+
+TEST(rc4, streambuf_failed_write_retry_ok) {
+    // Writes at most limit bytes
+    struct limited_buffer : public std::stringbuf {
+        std::streamsize limit = std::numeric_limits<std::streamsize>::max();
+
+        std::streamsize xsputn(const char* ptr, std::streamsize count) override {
+            count  = std::min(count, limit);
+            limit -= count;
+
+            return std::stringbuf::xsputn(ptr, count);
+        }
+    };
+
+    std::vector<uint8_t> data(5000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 3 + 7);
+
+    rc4 rc4;
+    rc4.set_key("testing");
+
+    limited_buffer inner;
+    inner.limit = 1500;
+
+    {
+        rc4_streambuf buffer(&inner, rc4, 1024);
+        std::ostream stream(&buffer);
+
+        stream.write((const char*)data.data(), data.size());
+        EXPECT_FALSE(stream.flush());
+
+        inner.limit = std::numeric_limits<std::streamsize>::max();
+        stream.clear();
+
+        EXPECT_TRUE(stream.write((const char*)data.data() + 2048, data.size() - 2048));
+        EXPECT_TRUE(stream.flush());
+    }
+
+    auto expected = data;
+    rc4.encrypt_buffer(expected);
+
+    std::string encrypted_data = inner.str();
+    EXPECT_TRUE(compare_buffers(std::vector<uint8_t>(encrypted_data.begin(), encrypted_data.end()), expected));
+}
+
+TEST(rc4, buffer_encrypt_hash_fused_ok) {
+    rc4 rc4;
+    md5 md5;
+
+    rc4.set_key("testing");
+    rc4.set_iv(91);
+
+    for (size_t size : { 0, 100, 5000, 100000 }) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++)
+            data[i] = (uint8_t)(i * 7 + 1);
+
+        auto encrypted = data;
+        rc4.encrypt_buffer(encrypted);
+
+        rc4::hash_t hash;
+        auto fused = data;
+
+        EXPECT_TRUE(rc4.encrypt_buffer(fused, hash));
+        EXPECT_TRUE(compare_buffers(fused, encrypted));
+        EXPECT_TRUE(hash == md5.compute(encrypted.data(), encrypted.size()));
+
+        fused = data;
+
+        EXPECT_TRUE(rc4.encrypt_buffer(fused, hash, rc4::hashed_data::plaintext));
+        EXPECT_TRUE(compare_buffers(fused, encrypted));
+        EXPECT_TRUE(hash == md5.compute(data.data(), data.size()));
+
+        EXPECT_TRUE(rc4.decrypt_buffer(fused, hash, rc4::hashed_data::plaintext));
+        EXPECT_TRUE(compare_buffers(fused, data));
+
+        fused = encrypted;
+
+        EXPECT_TRUE(rc4.decrypt_buffer(fused, md5.compute(encrypted.data(), encrypted.size())));
+        EXPECT_TRUE(compare_buffers(fused, data));
+
+        if (size != 0) {
+            fused = encrypted;
+            fused[size / 2] ^= 1;
+
+            EXPECT_FALSE(rc4.decrypt_buffer(fused, md5.compute(encrypted.data(), encrypted.size())));
+        }
+    }
+}
+
+TEST(rc4, container_encrypt_decrypt_ok) {
+    rc4_container container;
+
+    container.set_key("testing");
+    container.set_iv(5);
+    container.set_block_size(1000);
+    container.set_thread_count(4);
+
+    for (size_t size : { 0, 1, 999, 1000, 1001, 50000 }) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++)
+            data[i] = (uint8_t)(i * 13 + 3);
+
+        std::vector<uint8_t> encrypted, decrypted;
+
+        EXPECT_TRUE(container.encrypt_buffer(data, encrypted));
+        EXPECT_TRUE(container.decrypt_buffer(encrypted, decrypted));
+        EXPECT_TRUE(compare_buffers(decrypted, data));
+    }
+
+    std::vector<uint8_t> data(50000, 0x42), encrypted, decrypted;
+    EXPECT_TRUE(container.encrypt_buffer(data, encrypted));
+
+    // Single threaded output is the same
+    std::vector<uint8_t> serial;
+    container.set_thread_count(1);
+    EXPECT_TRUE(container.encrypt_buffer(data, serial));
+    EXPECT_TRUE(compare_buffers(serial, encrypted));
+
+    // Blocks don't share keystream
+    EXPECT_FALSE(std::equal(encrypted.end() - 2000, encrypted.end() - 1000, encrypted.end() - 1000));
+
+    container.set_iv(6);
+    EXPECT_FALSE(container.decrypt_buffer(encrypted, decrypted) && compare_buffers(decrypted, data));
+    container.set_iv(5);
+
+    encrypted[encrypted.size() - 10] ^= 1;
+    EXPECT_FALSE(container.decrypt_buffer(encrypted, decrypted));
+
+    encrypted.pop_back();
+    EXPECT_FALSE(container.decrypt_buffer(encrypted, decrypted));
+}
+
+TEST(rc4, container_file_random_read_ok) {
+    auto input     = std::filesystem::temp_directory_path() / "libcrypt_container_input.bin";
+    auto encrypted = std::filesystem::temp_directory_path() / "libcrypt_container_encrypted.bin";
+    auto decrypted = std::filesystem::temp_directory_path() / "libcrypt_container_decrypted.bin";
+
+    std::vector<uint8_t> data(100000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 31 + 7);
+
+    write_file(input, data);
+
+    rc4_container container;
+    container.set_key("0x6B6579");
+    container.set_block_size(4096);
+
+    EXPECT_FALSE(container.encrypt_file(input, input));
+    EXPECT_TRUE(container.encrypt_file(input, encrypted));
+    EXPECT_TRUE(container.decrypt_file(encrypted, decrypted));
+    EXPECT_TRUE(compare_buffers(read_file(decrypted), data));
+
+    EXPECT_TRUE(container.open(encrypted));
+    EXPECT_EQ(container.get_size(), data.size());
+
+    for (size_t offset : { 0, 1, 4095, 4096, 10000, 99000 }) {
+        std::vector<uint8_t> part(std::min<size_t>(5000, data.size() - offset));
+
+        EXPECT_TRUE(container.read(part.data(), part.size(), offset));
+        EXPECT_TRUE(std::equal(part.begin(), part.end(), data.begin() + offset));
+    }
+
+    uint8_t byte = 0U;
+    EXPECT_FALSE(container.read(&byte, 1, data.size()));
+
+    container.close();
+
+    // Corrupted block only fails reads that touch it
+    auto file = read_file(encrypted);
+    file[file.size() - 1] ^= 1;
+    write_file(encrypted, file);
+
+    EXPECT_TRUE(container.open(encrypted));
+    EXPECT_TRUE(container.read(&byte, 1, 0));
+    EXPECT_EQ(byte, data[0]);
+    EXPECT_FALSE(container.read(&byte, 1, data.size() - 1));
+
+    container.close();
+
+    // Failed decryption leaves the old output and no temporary file
+    write_file(decrypted, { 1, 2, 3 });
+    EXPECT_FALSE(container.decrypt_file(encrypted, decrypted));
+    EXPECT_TRUE(compare_buffers(read_file(decrypted), { 1, 2, 3 }));
+    EXPECT_FALSE(std::filesystem::exists(decrypted.string() + ".tmp"));
+
+    std::filesystem::remove(input);
+    std::filesystem::remove(encrypted);
+    std::filesystem::remove(decrypted);
+}
+
+TEST(rc4, container_same_file_rejected) {
+    auto dir   = std::filesystem::temp_directory_path() / "libcrypt_container_same";
+    auto input = dir / "input.bin";
+
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    std::vector<uint8_t> data(5000, 0x17);
+    write_file(input, data);
+
+    rc4_container container;
+    container.set_key("testing");
+
+    std::error_code error;
+    std::filesystem::create_hard_link(input, dir / "link.bin", error);
+    bool linked = !error;
+
+    // Same file under another path or a hard link
+    EXPECT_FALSE(container.encrypt_file(input, dir / "." / "input.bin"));
+    EXPECT_FALSE(container.decrypt_file(input, dir / "sub" / ".." / "input.bin"));
+
+    if (linked) {
+        EXPECT_FALSE(container.encrypt_file(input, dir / "link.bin"));
+    }
+
+    EXPECT_TRUE(compare_buffers(read_file(input), data));
+
+    std::filesystem::remove_all(dir);
+}
\ No newline at end of file